@@ -1,30 +1,9 @@
-QT       += core gui
+TEMPLATE = subdirs
 
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+SUBDIRS += \
+    core \
+    src \
+    benchmark
 
-CONFIG += c++11
-
-# You can make your code fail to compile if it uses deprecated APIs.
-# In order to do so, uncomment the following line.
-#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
-
-SOURCES += \
-    src/calculator.cpp \
-    src/items.cpp \
-    src/scene.cpp \
-    src/main.cpp \
-    src/view.cpp \
-    src/window.cpp
-
-HEADERS += \
-    src/calculator.h \
-    src/data.h \
-    src/items.h \
-    src/scene.h \
-    src/view.h \
-    src/window.h
-
-# Default rules for deployment.
-qnx: target.path = /tmp/$${TARGET}/bin
-else: unix:!android: target.path = /opt/$${TARGET}/bin
-!isEmpty(target.path): INSTALLS += target
+src.depends = core
+benchmark.depends = core
@@ -0,0 +1,59 @@
+QT       += core gui widgets network concurrent
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = measurerbenchmark
+
+SOURCES += \
+    main.cpp \
+    ../src/bufferpool.cpp \
+    ../src/calculator.cpp \
+    ../src/edgemap.cpp \
+    ../src/pngreader.cpp \
+    ../src/profiler.cpp \
+    ../src/screencapturer.cpp \
+    ../src/tiledimage.cpp \
+    ../src/transitiontable.cpp
+
+HEADERS += \
+    ../src/bufferpool.h \
+    ../src/calculator.h \
+    ../src/edgemap.h \
+    ../src/framering.h \
+    ../src/pngreader.h \
+    ../src/profiler.h \
+    ../src/screencapturer.h \
+    ../src/tiledimage.h \
+    ../src/transitiontable.h
+
+unix|win32-g++ {
+    DEFINES += SPM_HAVE_ZLIB
+    LIBS += -lz
+}
+
+unix:!macx: LIBS += -lrt
+
+CONFIG(debug, debug|release)|count_allocations {
+    DEFINES += SPM_COUNT_ALLOCATIONS
+    SOURCES += ../src/allocationhook.cpp
+}
+
+unix:!macx:packagesExist(x11 xext) {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += x11 xext
+    DEFINES += SPM_HAVE_XSHM
+}
+
+INCLUDEPATH += $$PWD/../core $$PWD/../src
+DEPENDPATH += $$PWD/../core $$PWD/../src
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../core/release/ -lmeasurercore
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../core/debug/ -lmeasurercore
+else:unix: LIBS += -L$$OUT_PWD/../core/ -lmeasurercore
+
+win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../core/release/libmeasurercore.a
+else:win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../core/debug/libmeasurercore.a
+else:win32:!win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../core/release/measurercore.lib
+else:win32:!win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../core/debug/measurercore.lib
+else:unix: PRE_TARGETDEPS += $$OUT_PWD/../core/libmeasurercore.a
@@ -0,0 +1,534 @@
+#include <QApplication>
+#include <QDesktopWidget>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalSocket>
+#include <QPainter>
+#include <QProcess>
+#include <QRandomGenerator>
+#include <QRegularExpression>
+#include <QScreen>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "measurer.h"
+#include "calculator.h"
+#include "screencapturer.h"
+#include "measurementserver.h"
+#include "framering.h"
+#include "profiler.h"
+
+namespace {
+
+const QSize kImageSize{3840, 2160};
+const int kElementCount{400};
+const int kQueryCount{2000};
+const int kGrabCount{50};
+const int kStartupRuns{10};
+const int kStartupTimeout{10000};
+const int kServiceBatches{50};
+const int kServiceBatchSize{1000};
+const int kServiceTimeout{30000};
+const QSize kRingFrameSize{1920, 1080};
+const quint32 kRingSlots{4};
+const int kRingFrames{600};
+const int kRingFrameInterval{16};
+const QSize kTranslucentSize{64, 16};
+const int kTranslucentEdge{40};
+
+int genericBeamTo(int startPos, int endPos, int coord, int step,
+                  Qt::Orientation orientation, const QRgb& color, const QImage& img)
+{
+    int resPos = endPos;
+    for (int pos = startPos + step; pos != endPos; pos += step)
+    {
+        auto point = orientation == Qt::Horizontal ? QPoint(pos, coord)
+                                                   : QPoint(coord, pos);
+
+        if (!img.rect().contains(point))
+        {
+            break;
+        }
+
+        if (img.pixel(point) != color)
+        {
+            return pos - step;
+        }
+    }
+    return resPos;
+}
+
+QRect genericCursorRectangle(const QPoint& pos, const QImage& img)
+{
+    auto x = pos.x();
+    auto y = pos.y();
+    auto color = img.pixel(pos);
+    auto cr = genericBeamTo(x, img.width() - 1, y, 1, Qt::Horizontal, color, img);
+    auto cl = genericBeamTo(x, 0, y, -1, Qt::Horizontal, color, img);
+    auto cb = genericBeamTo(y, img.height() - 1, x, 1, Qt::Vertical, color, img);
+    auto ct = genericBeamTo(y, 0, x, -1, Qt::Vertical, color, img);
+
+    return {cl, ct, cr - cl, cb - ct};
+}
+
+QImage createScreen()
+{
+    QImage img(kImageSize, QImage::Format_RGB32);
+    img.fill(0x333333);
+
+    QPainter painter(&img);
+    auto random = QRandomGenerator(42);
+
+    for (int i = 0; i < kElementCount; ++i)
+    {
+        QRect rect{random.bounded(kImageSize.width()), random.bounded(kImageSize.height()),
+                   random.bounded(16, 800), random.bounded(16, 300)};
+        painter.fillRect(rect, QColor::fromRgb(random.generate() & 0xf0f0f0));
+    }
+
+    return img;
+}
+
+spm::PixelView toPixelView(const QImage& img, spm::PixelFormat format)
+{
+    spm::PixelView view;
+    view.data = img.constBits();
+    view.stride = img.bytesPerLine();
+    view.width = img.width();
+    view.height = img.height();
+    view.format = format;
+
+    return view;
+}
+
+int checkTranslucentBeam(QTextStream& out)
+{
+    QImage img(kTranslucentSize, QImage::Format_ARGB32_Premultiplied);
+    img.fill(QColor(200, 100, 50, 128));
+
+    for (int y = 0; y < img.height(); ++y)
+    {
+        reinterpret_cast<QRgb*>(img.scanLine(y))[kTranslucentEdge] = qPremultiply(qRgba(20, 40, 60, 64));
+    }
+
+    auto edge = Calculator::beamTo(0, img.width() - 1, 0, 1, Qt::Horizontal, img.pixel(0, 0), img);
+
+    out << QString("Translucent premultiplied beam: edge %1, expected %2\n").arg(edge).arg(kTranslucentEdge - 1);
+
+    if (edge != kTranslucentEdge - 1)
+    {
+        out << "FAILED: the beam over a translucent premultiplied image stopped at the wrong pixel\n";
+        return 1;
+    }
+
+    return 0;
+}
+
+int benchmarkCapture(int argc, char* argv[])
+{
+    QApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    auto screen = QGuiApplication::primaryScreen();
+    auto winId = QApplication::desktop()->winId();
+    auto rect = screen->geometry();
+    ScreenCapturer sharedCapturer;
+    ScreenCapturer qtCapturer(false);
+
+    const std::vector<std::pair<QString, std::function<QImage()>>> backends{
+        {"grabWindow + copy", [&](){ return screen->grabWindow(winId).copy(rect).toImage(); }},
+        {"grabWindow region", [&](){ return qtCapturer.grab(rect); }},
+        {"XShm", [&](){ return sharedCapturer.grab(rect); }}
+    };
+
+    out << QString("Screen capture, %1x%2, %3 grabs, XShm %4\n")
+           .arg(rect.width()).arg(rect.height()).arg(kGrabCount)
+           .arg(sharedCapturer.isSharedMemoryAvailable() ? "available" : "unavailable");
+    out << QString("%1 %2\n").arg("backend", -22).arg("ms/grab", 10);
+
+    for (const auto& backend : backends)
+    {
+        QElapsedTimer timer;
+        timer.start();
+
+        for (int i = 0; i < kGrabCount; ++i)
+        {
+            backend.second();
+        }
+
+        out << QString("%1 %2\n")
+               .arg(backend.first, -22)
+               .arg(timer.nsecsElapsed() / 1e6 / kGrabCount, 10, 'f', 2);
+    }
+
+    return 0;
+}
+
+qint64 median(std::vector<qint64> values)
+{
+    std::sort(values.begin(), values.end());
+
+    return values.empty() ? 0 : values[values.size() / 2];
+}
+
+int benchmarkStartup(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    auto program = argc > 2 ? QString(argv[2])
+                            : QCoreApplication::applicationDirPath() + "/../src/ScreenPixelMeasurer";
+    QRegularExpression pattern("first frame (\\d+) ms, first measurement (\\d+) ms");
+    std::vector<qint64> launches;
+    std::vector<qint64> frames;
+    std::vector<qint64> measurements;
+
+    out << QString("Startup, %1, %2 runs\n").arg(program).arg(kStartupRuns);
+    out << QString("%1 %2 %3 %4\n")
+           .arg("run", 4).arg("process ms", 12).arg("frame ms", 10).arg("measure ms", 12);
+
+    for (int i = 0; i < kStartupRuns; ++i)
+    {
+        QProcess process;
+        QElapsedTimer timer;
+        timer.start();
+
+        process.start(program, {"--startup-report"});
+
+        if (!process.waitForFinished(kStartupTimeout))
+        {
+            process.kill();
+            out << QString("%1 timed out\n").arg(i + 1, 4);
+            return 1;
+        }
+
+        auto match = pattern.match(QString::fromLocal8Bit(process.readAllStandardOutput()));
+
+        if (!match.hasMatch())
+        {
+            out << QString("%1 no startup report\n").arg(i + 1, 4);
+            return 1;
+        }
+
+        launches.push_back(timer.elapsed());
+        frames.push_back(match.captured(1).toLongLong());
+        measurements.push_back(match.captured(2).toLongLong());
+
+        out << QString("%1 %2 %3 %4\n")
+               .arg(i + 1, 4).arg(launches.back(), 12).arg(frames.back(), 10).arg(measurements.back(), 12);
+    }
+
+    out << QString("%1 %2 %3 %4\n")
+           .arg("p50", 4).arg(median(launches), 12).arg(median(frames), 10).arg(median(measurements), 12);
+
+    return 0;
+}
+
+QByteArray serviceBatch(int id, const QVector<QPoint>& points, bool isJson)
+{
+    if (isJson)
+    {
+        QJsonArray queries;
+
+        for (const auto& point : points)
+        {
+            queries.append(QJsonObject{{"op", "rect"}, {"at", QJsonArray{point.x(), point.y()}}});
+        }
+
+        return QJsonDocument(QJsonObject{{"id", id}, {"queries", queries}}).toJson(QJsonDocument::Compact) + '\n';
+    }
+
+    MeasurementServer::Header header;
+    std::memcpy(header.magic, "SPMQ", sizeof(header.magic));
+    header.id = quint32(id);
+    header.count = quint32(points.size());
+    header.pathLength = 0;
+
+    QByteArray data(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (const auto& point : points)
+    {
+        MeasurementServer::Query query{MeasurementServer::Rectangle, {point.x(), point.y(), 0, 0}};
+        data.append(reinterpret_cast<const char*>(&query), sizeof(query));
+    }
+
+    return data;
+}
+
+int benchmarkService(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    auto name = argc > 2 ? QString(argv[2]) : QString("ScreenPixelMeasurer");
+    auto random = QRandomGenerator(7);
+    QVector<QPoint> points;
+
+    for (int i = 0; i < kServiceBatchSize; ++i)
+    {
+        points.push_back({random.bounded(1000), random.bounded(700)});
+    }
+
+    out << QString("Measurement service %1, %2 batches of %3 rect queries\n")
+           .arg(name).arg(kServiceBatches).arg(kServiceBatchSize);
+    out << QString("%1 %2 %3\n").arg("protocol", -10).arg("queries/s", 12).arg("ms/batch", 10);
+
+    for (auto isJson : {false, true})
+    {
+        QLocalSocket socket;
+        socket.connectToServer(name);
+
+        if (!socket.waitForConnected(kServiceTimeout))
+        {
+            out << "Cannot connect, run \"ScreenPixelMeasurer --serve " << name << "\" first\n";
+            return 1;
+        }
+
+        QByteArray requests;
+
+        for (int i = 0; i < kServiceBatches; ++i)
+        {
+            requests += serviceBatch(i, points, isJson);
+        }
+
+        auto binaryReplySize = qint64(kServiceBatches) *
+                (sizeof(MeasurementServer::Header) + kServiceBatchSize * sizeof(MeasurementServer::Result));
+        int replies{0};
+        qint64 received{0};
+
+        QElapsedTimer timer;
+        timer.start();
+        socket.write(requests);
+
+        while ((isJson ? replies < kServiceBatches : received < binaryReplySize) &&
+               timer.elapsed() < kServiceTimeout && socket.waitForReadyRead(kServiceTimeout))
+        {
+            auto data = socket.readAll();
+            received += data.size();
+            replies += data.count('\n');
+        }
+
+        auto elapsed = timer.nsecsElapsed() / 1e9;
+
+        out << QString("%1 %2 %3\n")
+               .arg(isJson ? "json" : "binary", -10)
+               .arg(kServiceBatches * kServiceBatchSize / elapsed, 12, 'f', 0)
+               .arg(elapsed * 1000 / kServiceBatches, 10, 'f', 2);
+    }
+
+    return 0;
+}
+
+int benchmarkProducer(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+#ifdef Q_OS_UNIX
+    auto name = argc > 2 ? QString(argv[2]) : QString("ScreenPixelMeasurer");
+    auto path = ('/' + name).toLocal8Bit();
+    auto bytesPerLine = kRingFrameSize.width() * int(sizeof(QRgb));
+    auto slotSize = quint64(bytesPerLine) * quint64(kRingFrameSize.height());
+    auto dataOffset = quint64(4096);
+    auto size = dataOffset + slotSize * kRingSlots;
+
+    auto fd = shm_open(path.constData(), O_CREAT | O_RDWR, 0600);
+    auto address = fd >= 0 && ftruncate(fd, off_t(size)) == 0
+            ? mmap(nullptr, size_t(size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+            : MAP_FAILED;
+
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+
+    if (address == MAP_FAILED)
+    {
+        out << "Cannot create shared memory " << path << "\n";
+        return 1;
+    }
+
+    auto memory = static_cast<uchar*>(address);
+    auto header = reinterpret_cast<FrameRing::Header*>(memory);
+    auto slots = reinterpret_cast<FrameRing::Slot*>(memory + sizeof(FrameRing::Header));
+
+    std::memset(memory, 0, size_t(dataOffset));
+    std::memcpy(header->magic, "SPMF", sizeof(header->magic));
+    header->version = FrameRing::kVersion;
+    header->slotCount = kRingSlots;
+
+    out << QString("Frame ring %1, %2x%3, %4 slots, %5 frames, run \"ScreenPixelMeasurer --ingest %1\"\n")
+           .arg(name).arg(kRingFrameSize.width()).arg(kRingFrameSize.height()).arg(kRingSlots).arg(kRingFrames);
+
+    auto screen = createScreen();
+    qint64 publishTime{0};
+
+    for (quint64 generation = 1; generation <= quint64(kRingFrames); ++generation)
+    {
+        QElapsedTimer timer;
+        timer.start();
+
+        auto& slot = slots[generation % kRingSlots];
+        auto offset = dataOffset + slotSize * (generation % kRingSlots);
+        QImage frame(memory + offset, kRingFrameSize.width(), kRingFrameSize.height(),
+                     bytesPerLine, QImage::Format_RGB32);
+        QPainter painter(&frame);
+        painter.drawImage(0, 0, screen, int(generation * 4 % quint64(kImageSize.width() - kRingFrameSize.width())), 0);
+        painter.fillRect(int(generation % 1600), 400, 200, 120, Qt::white);
+        painter.end();
+
+        slot.width = kRingFrameSize.width();
+        slot.height = kRingFrameSize.height();
+        slot.bytesPerLine = bytesPerLine;
+        slot.offset = offset;
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.generation = generation;
+        std::atomic_thread_fence(std::memory_order_release);
+        header->generation = generation;
+
+        publishTime += timer.nsecsElapsed();
+        QThread::msleep(kRingFrameInterval);
+    }
+
+    out << QString("%1 ms/frame to render and publish\n").arg(publishTime / 1e6 / kRingFrames, 0, 'f', 2);
+
+    munmap(address, size_t(size));
+    shm_unlink(path.constData());
+
+    return 0;
+#else
+    Q_UNUSED(argc)
+    Q_UNUSED(argv)
+    out << "POSIX shared memory is not available\n";
+    return 1;
+#endif
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1 && QString(argv[1]) == "capture")
+    {
+        return benchmarkCapture(argc, argv);
+    }
+
+    if (argc > 1 && QString(argv[1]) == "service")
+    {
+        return benchmarkService(argc, argv);
+    }
+
+    if (argc > 1 && QString(argv[1]) == "produce")
+    {
+        return benchmarkProducer(argc, argv);
+    }
+
+    if (argc > 1 && QString(argv[1]) == "startup")
+    {
+        return benchmarkStartup(argc, argv);
+    }
+
+    QTextStream out(stdout);
+
+    if (checkTranslucentBeam(out))
+    {
+        return 1;
+    }
+
+    const std::vector<std::pair<QImage::Format, spm::PixelFormat>> formats{
+        {QImage::Format_RGB32, spm::PixelFormat::RGB32},
+        {QImage::Format_ARGB32_Premultiplied, spm::PixelFormat::ARGB32Premultiplied},
+        {QImage::Format_RGB888, spm::PixelFormat::RGB888},
+        {QImage::Format_RGB16, spm::PixelFormat::RGB16},
+        {QImage::Format_Grayscale8, spm::PixelFormat::Grayscale8}
+    };
+    const QStringList names{"RGB32", "ARGB32 premultiplied", "RGB888", "RGB16", "Grayscale8"};
+
+    auto screen = createScreen();
+    auto random = QRandomGenerator(7);
+    QVector<QPoint> points;
+
+    for (int i = 0; i < kQueryCount; ++i)
+    {
+        points.push_back({random.bounded(kImageSize.width()), random.bounded(kImageSize.height())});
+    }
+
+    out << QString("Cursor rectangle, %1x%2, %3 queries\n")
+           .arg(kImageSize.width()).arg(kImageSize.height()).arg(kQueryCount);
+    out << QString("%1 %2 %3 %4 %5 %6\n")
+           .arg("format", -22).arg("generic us", 12).arg("kernel us", 12).arg("speedup", 8).arg("mismatches", 10)
+           .arg("allocations", 12);
+
+    qint64 totalAllocations{0};
+
+    for (size_t i = 0; i < formats.size(); ++i)
+    {
+        auto img = screen.convertToFormat(formats[i].first);
+        auto view = toPixelView(img, formats[i].second);
+        QVector<QRect> generic;
+        QVector<spm::Rect> kernel;
+        generic.reserve(kQueryCount);
+        kernel.reserve(kQueryCount);
+
+        QElapsedTimer timer;
+        timer.start();
+
+        for (const auto& point : points)
+        {
+            generic.push_back(genericCursorRectangle(point, img));
+        }
+
+        auto genericTime = timer.nsecsElapsed();
+        auto allocations = Profiler::heapAllocationCount();
+        timer.restart();
+
+        for (const auto& point : points)
+        {
+            kernel.push_back(spm::Measurer::cursorRectangle({point.x(), point.y()}, view));
+        }
+
+        auto kernelTime = timer.nsecsElapsed();
+        allocations = Profiler::heapAllocationCount() - allocations;
+        totalAllocations += allocations;
+        int mismatches{0};
+
+        for (int j = 0; j < kQueryCount; ++j)
+        {
+            int x1, y1, x2, y2;
+            generic[j].getCoords(&x1, &y1, &x2, &y2);
+
+            if (kernel[j] != spm::Rect{x1, y1, x2, y2})
+            {
+                ++mismatches;
+            }
+        }
+
+        out << QString("%1 %2 %3 %4 %5 %6\n")
+               .arg(names[int(i)], -22)
+               .arg(genericTime / 1000.0 / kQueryCount, 12, 'f', 2)
+               .arg(kernelTime / 1000.0 / kQueryCount, 12, 'f', 2)
+               .arg(double(genericTime) / qMax<qint64>(kernelTime, 1), 8, 'f', 1)
+               .arg(mismatches, 10)
+               .arg(Profiler::isHeapAllocationCounted() ? QString::number(allocations) : QString("n/a"), 12);
+    }
+
+    if (totalAllocations > 0)
+    {
+        out << QString("FAILED: %1 heap allocations in the kernel queries\n").arg(totalAllocations);
+        return 1;
+    }
+
+    return 0;
+}
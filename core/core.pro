@@ -0,0 +1,17 @@
+TEMPLATE = lib
+
+CONFIG += staticlib c++11
+CONFIG -= qt
+
+TARGET = measurercore
+
+SOURCES += \
+    distancefield.cpp \
+    measurer.cpp
+
+HEADERS += \
+    distancefield.h \
+    geometry.h \
+    measurer.h \
+    pixelformats.h \
+    pixelview.h
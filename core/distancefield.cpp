@@ -0,0 +1,185 @@
+#include <cmath>
+#include <limits>
+
+#include "distancefield.h"
+#include "pixelformats.h"
+
+namespace spm {
+
+const std::uint32_t DistanceField::kInfinite;
+
+void DistanceField::reset(int width, int height)
+{
+    auto size = std::size_t(width) * std::size_t(height);
+
+    m_width = width;
+    m_height = height;
+    m_nearestRow.assign(size, -1);
+    m_nearestColumn.assign(size, -1);
+    m_squaredDistance.assign(size, kInfinite);
+}
+
+void DistanceField::computeColumns(const PixelView& view, int begin, int end)
+{
+    switch (view.format)
+    {
+    case PixelFormat::RGB32: computeColumnsFor<Rgb32Pixel>(view, begin, end); break;
+    case PixelFormat::ARGB32:
+    case PixelFormat::ARGB32Premultiplied: computeColumnsFor<Argb32Pixel>(view, begin, end); break;
+    case PixelFormat::RGB888: computeColumnsFor<Rgb888Pixel>(view, begin, end); break;
+    case PixelFormat::RGB16: computeColumnsFor<Rgb16Pixel>(view, begin, end); break;
+    case PixelFormat::Grayscale8: computeColumnsFor<Grayscale8Pixel>(view, begin, end); break;
+    }
+}
+
+void DistanceField::computeRows(int begin, int end)
+{
+    const auto infinity = std::numeric_limits<double>::infinity();
+    const auto unreachable = 1e20;
+    const auto w = m_width;
+
+    std::vector<double> f(std::size_t(w), 0.0);
+    std::vector<double> z(std::size_t(w) + 1, 0.0);
+    std::vector<int> v(std::size_t(w), 0);
+
+    for (int y = begin; y < end; ++y)
+    {
+        auto nearestRow = &m_nearestRow[std::size_t(y) * w];
+
+        for (int x = 0; x < w; ++x)
+        {
+            auto dy = nearestRow[x] < 0 ? unreachable : double(nearestRow[x] - y);
+            f[x] = nearestRow[x] < 0 ? unreachable : dy * dy;
+        }
+
+        int k{0};
+        v[0] = 0;
+        z[0] = -infinity;
+        z[1] = infinity;
+
+        for (int q = 1; q < w; ++q)
+        {
+            auto s = ((f[q] + double(q) * q) - (f[v[k]] + double(v[k]) * v[k])) / (2.0 * q - 2.0 * v[k]);
+
+            while (s <= z[k])
+            {
+                --k;
+                s = ((f[q] + double(q) * q) - (f[v[k]] + double(v[k]) * v[k])) / (2.0 * q - 2.0 * v[k]);
+            }
+
+            ++k;
+            v[k] = q;
+            z[k] = s;
+            z[k + 1] = infinity;
+        }
+
+        k = 0;
+
+        auto squaredDistance = &m_squaredDistance[std::size_t(y) * w];
+        auto nearestColumn = &m_nearestColumn[std::size_t(y) * w];
+
+        for (int x = 0; x < w; ++x)
+        {
+            while (z[k + 1] < x)
+            {
+                ++k;
+            }
+
+            auto dx = double(x - v[k]);
+            auto d = dx * dx + f[v[k]];
+
+            squaredDistance[x] = d >= double(kInfinite) ? kInfinite : std::uint32_t(d);
+            nearestColumn[x] = d >= double(kInfinite) ? -1 : v[k];
+        }
+    }
+}
+
+bool DistanceField::isNull() const
+{
+    return m_width <= 0 || m_height <= 0;
+}
+
+int DistanceField::width() const
+{
+    return m_width;
+}
+
+int DistanceField::height() const
+{
+    return m_height;
+}
+
+std::uint32_t DistanceField::squaredDistance(const Point& pos) const
+{
+    if (pos.x < 0 || pos.x >= m_width || pos.y < 0 || pos.y >= m_height)
+    {
+        return kInfinite;
+    }
+
+    return m_squaredDistance[std::size_t(pos.y) * m_width + pos.x];
+}
+
+double DistanceField::distance(const Point& pos) const
+{
+    auto squared = squaredDistance(pos);
+
+    return squared == kInfinite ? std::numeric_limits<double>::infinity() : std::sqrt(double(squared));
+}
+
+Point DistanceField::nearest(const Point& pos) const
+{
+    if (squaredDistance(pos) == kInfinite)
+    {
+        return pos;
+    }
+
+    auto index = std::size_t(pos.y) * m_width;
+    auto x = m_nearestColumn[index + pos.x];
+
+    return {x, m_nearestRow[index + x]};
+}
+
+template<typename Pixel>
+void DistanceField::computeColumnsFor(const PixelView& view, int begin, int end)
+{
+    const auto w = m_width;
+    const auto h = m_height;
+
+    for (int y = 0; y < h; ++y)
+    {
+        auto line = view.data + y * view.stride;
+        auto prevLine = y > 0 ? line - view.stride : nullptr;
+        auto nextLine = y + 1 < h ? line + view.stride : nullptr;
+        auto nearestRow = &m_nearestRow[std::size_t(y) * w];
+        auto prevNearestRow = y > 0 ? nearestRow - w : nullptr;
+
+        for (int x = begin; x < end; ++x)
+        {
+            auto color = Pixel::read(line + x * Pixel::kBytes);
+            auto isEdge = (x > 0 && Pixel::read(line + (x - 1) * Pixel::kBytes) != color) ||
+                          (x + 1 < w && Pixel::read(line + (x + 1) * Pixel::kBytes) != color) ||
+                          (prevLine && Pixel::read(prevLine + x * Pixel::kBytes) != color) ||
+                          (nextLine && Pixel::read(nextLine + x * Pixel::kBytes) != color);
+
+            nearestRow[x] = isEdge ? y : (prevNearestRow ? prevNearestRow[x] : -1);
+        }
+    }
+
+    for (int y = h - 2; y >= 0; --y)
+    {
+        auto nearestRow = &m_nearestRow[std::size_t(y) * w];
+        auto nextNearestRow = nearestRow + w;
+
+        for (int x = begin; x < end; ++x)
+        {
+            auto next = nextNearestRow[x];
+
+            if (next >= 0 && (nearestRow[x] < 0 || next - y < y - nearestRow[x]))
+            {
+                nearestRow[x] = next;
+            }
+        }
+    }
+}
+
+} // namespace spm
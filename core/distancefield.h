@@ -0,0 +1,42 @@
+#ifndef DISTANCEFIELD_H
+#define DISTANCEFIELD_H
+
+#include <cstdint>
+#include <vector>
+
+#include "geometry.h"
+#include "pixelview.h"
+
+namespace spm {
+
+class DistanceField
+{
+public:
+    static const std::uint32_t kInfinite{0xffffffffu};
+
+    void reset(int width, int height);
+    void computeColumns(const PixelView& view, int begin, int end);
+    void computeRows(int begin, int end);
+
+    bool isNull() const;
+    int width() const;
+    int height() const;
+    std::uint32_t squaredDistance(const Point& pos) const;
+    double distance(const Point& pos) const;
+    Point nearest(const Point& pos) const;
+
+private:
+    int m_width{0};
+    int m_height{0};
+    std::vector<std::int32_t> m_nearestRow;
+    std::vector<std::int32_t> m_nearestColumn;
+    std::vector<std::uint32_t> m_squaredDistance;
+
+private:
+    template<typename Pixel>
+    void computeColumnsFor(const PixelView& view, int begin, int end);
+};
+
+} // namespace spm
+
+#endif // DISTANCEFIELD_H
@@ -0,0 +1,94 @@
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+namespace spm {
+
+enum class Orientation {
+    Horizontal,
+    Vertical
+};
+
+struct Point {
+    Point(int x = 0, int y = 0) : x(x), y(y) {}
+
+    int x;
+    int y;
+};
+
+struct Line {
+    Line(const Point& p1 = {}, const Point& p2 = {}) : p1(p1), p2(p2) {}
+
+    Point p1;
+    Point p2;
+};
+
+struct Rect {
+    Rect(int x1 = 0, int y1 = 0, int x2 = -1, int y2 = -1) : x1(x1), y1(y1), x2(x2), y2(y2) {}
+
+    int x1;
+    int y1;
+    int x2;
+    int y2;
+
+    static Rect fromSize(int x, int y, int width, int height)
+    {
+        return {x, y, x + width - 1, y + height - 1};
+    }
+
+    int width() const { return x2 - x1 + 1; }
+    int height() const { return y2 - y1 + 1; }
+    bool isNull() const { return x2 == x1 - 1 && y2 == y1 - 1; }
+    Point center() const { return {int((static_cast<long long>(x1) + x2) / 2),
+                                    int((static_cast<long long>(y1) + y2) / 2)}; }
+
+    bool contains(const Point& p) const
+    {
+        int l = x1, r = x1, t = y1, b = y1;
+        if (x2 < x1 - 1) l = x2; else r = x2;
+        if (y2 < y1 - 1) t = y2; else b = y2;
+        return p.x >= l && p.x <= r && p.y >= t && p.y <= b;
+    }
+
+    bool contains(const Rect& rect) const
+    {
+        if (isNull() || rect.isNull())
+        {
+            return false;
+        }
+
+        int l1 = x1, r1 = x1, l2 = rect.x1, r2 = rect.x1;
+        if (x2 - x1 + 1 < 0) l1 = x2; else r1 = x2;
+        if (rect.x2 - rect.x1 + 1 < 0) l2 = rect.x2; else r2 = rect.x2;
+        if (l2 < l1 || r2 > r1) return false;
+
+        int t1 = y1, b1 = y1, t2 = rect.y1, b2 = rect.y1;
+        if (y2 - y1 + 1 < 0) t1 = y2; else b1 = y2;
+        if (rect.y2 - rect.y1 + 1 < 0) t2 = rect.y2; else b2 = rect.y2;
+        if (t2 < t1 || b2 > b1) return false;
+
+        return true;
+    }
+
+    bool operator==(const Rect& other) const
+    {
+        return x1 == other.x1 && y1 == other.y1 && x2 == other.x2 && y2 == other.y2;
+    }
+
+    bool operator!=(const Rect& other) const { return !(*this == other); }
+};
+
+struct RectF {
+    RectF(float x1 = 0, float y1 = 0, float x2 = 0, float y2 = 0) : x1(x1), y1(y1), x2(x2), y2(y2) {}
+
+    float x1;
+    float y1;
+    float x2;
+    float y2;
+
+    float width() const { return x2 - x1; }
+    float height() const { return y2 - y1; }
+};
+
+} // namespace spm
+
+#endif // GEOMETRY_H
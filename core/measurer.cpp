@@ -0,0 +1,347 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "measurer.h"
+#include "pixelformats.h"
+
+namespace spm {
+
+const int Measurer::kSubpixelWindow;
+const int Measurer::kSubpixelContrast;
+
+Rect Measurer::cursorRectangle(const Point& pos, const PixelView& view)
+{
+    switch (view.format)
+    {
+    case PixelFormat::RGB32: return cursorRectangleFor<Rgb32Pixel>(pos, view);
+    case PixelFormat::ARGB32:
+    case PixelFormat::ARGB32Premultiplied: return cursorRectangleFor<Argb32Pixel>(pos, view);
+    case PixelFormat::RGB888: return cursorRectangleFor<Rgb888Pixel>(pos, view);
+    case PixelFormat::RGB16: return cursorRectangleFor<Rgb16Pixel>(pos, view);
+    case PixelFormat::Grayscale8: return cursorRectangleFor<Grayscale8Pixel>(pos, view);
+    }
+
+    return {};
+}
+
+std::array<Line, 2> Measurer::cursorLines(const Point& pos, const Rect& cursorRect)
+{
+    auto x = pos.x;
+    auto y = pos.y;
+
+    return {{
+        Line{{cursorRect.x1, y}, {cursorRect.x2 + 1, y}},
+        Line{{x, cursorRect.y1}, {x, cursorRect.y2 + 1}}
+    }};
+}
+
+std::array<Line, 4> Measurer::fixedLines(const Rect& fixedRect, int width, int height)
+{
+    auto l = fixedRect.x1;
+    auto t = fixedRect.y1;
+    auto r = fixedRect.x2;
+    auto b = fixedRect.y2;
+
+    return {{
+        Line{{1, t}, {width - 1, t}},
+        Line{{1, b + 1}, {width - 1, b + 1}},
+        Line{{l, 1}, {l, height - 1}},
+        Line{{r + 1, 1}, {r + 1, height - 1}}
+    }};
+}
+
+std::array<Line, 2> Measurer::measureLines(const Rect& cursorRect, const Rect& fixedRect)
+{
+    int hx1{1}, hx2{1}, hy1{1}, hy2{1};
+    int vx1{1}, vx2{1}, vy1{1}, vy2{1};
+
+    auto cl = cursorRect.x1;
+    auto ct = cursorRect.y1;
+    auto cr = cursorRect.x2;
+    auto cb = cursorRect.y2;
+    auto fl = fixedRect.x1;
+    auto ft = fixedRect.y1;
+    auto fr = fixedRect.x2;
+    auto fb = fixedRect.y2;
+
+    auto ccx = cursorRect.center().x;
+    auto ccy = cursorRect.center().y;
+    auto fcx = fixedRect.center().x;
+    auto fcy = fixedRect.center().y;
+
+    if (cursorRect != fixedRect)
+    {
+        if (cursorRect.contains(fixedRect))
+        {
+            hx2 = fl - 1;   hy2 = fcy;      hx1 = cl;   hy1 = fcy;
+            vx2 = fcx;      vy2 = ft - 1;   vx1 = fcx;  vy1 = ct;
+        }
+        else if (fixedRect.contains(cursorRect))
+        {
+            hx2 = cl - 1;   hy2 = ccy;      hx1 = fl;   hy1 = ccy;
+            vx2 = ccx;      vy2 = ct - 1;   vx1 = ccx;  vy1 = ft;
+        }
+        else
+        {
+            vx1 = vx2 = ccx;
+            hy1 = hy2 = ccy;
+
+            if (cb < ft)
+            {
+                vy1 = cb + 2; vy2 = ft - 1;
+            }
+            else if (ct > fb)
+            {
+                vy1 = fb + 2; vy2 = ct - 1;
+            }
+            else
+            {
+                if (ct < ft)
+                {
+                    vy1 = ct; vy2 = ft - 1;
+                }
+                else if (ct > ft)
+                {
+                    vy1 = ft; vy2 = ct - 1;
+                }
+            }
+
+            if (cr < fl)
+            {
+                hx1 = cr + 2; hx2 = fl - 1;
+            }
+            else if (cl > fr)
+            {
+                hx1 = fr + 2; hx2 = cl - 1;
+            }
+            else
+            {
+                if (cl < fl)
+                {
+                    hx1 = cl;  hx2 = fl - 1;
+                }
+                else if (cl > fl)
+                {
+                    hx1 = fl; hx2 = cl - 1;
+                }
+            }
+        }
+    }
+
+    return {{
+        Line{{vx1, vy1}, {vx2, vy2}},
+        Line{{hx1, hy1}, {hx2, hy2}}
+    }};
+}
+
+RectF Measurer::subpixelRectangle(const Point& pos, const Rect& cursorRect, const PixelView& view)
+{
+    const Point edges[4] = {{cursorRect.x1, pos.y}, {pos.x, cursorRect.y1},
+                            {cursorRect.x2 + 1, pos.y}, {pos.x, cursorRect.y2 + 1}};
+    const Point steps[4] = {{-1, 0}, {0, -1}, {1, 0}, {0, 1}};
+    float inside[4] = {};
+    float outside[4] = {};
+    float samples[kSubpixelWindow - 1][4] = {};
+    float coverage[4] = {};
+
+    auto isInView = [&](const Point& p){
+        return p.x >= 0 && p.x < view.width && p.y >= 0 && p.y < view.height;
+    };
+
+    for (int i = 0; i < 4 && !view.isNull() && view.format != PixelFormat::RGB16; ++i)
+    {
+        Point last{edges[i].x + steps[i].x * kSubpixelWindow, edges[i].y + steps[i].y * kSubpixelWindow};
+
+        if (!isInView(edges[i]) || !isInView(last))
+        {
+            continue;
+        }
+
+        auto in = pixel(edges[i], view);
+        auto out = pixel(last, view);
+        auto shift = contrastShift(in, out);
+
+        inside[i] = float(in >> shift & 0xff);
+        outside[i] = float(out >> shift & 0xff);
+
+        for (int k = 1; k < kSubpixelWindow; ++k)
+        {
+            auto value = pixel({edges[i].x + steps[i].x * k, edges[i].y + steps[i].y * k}, view);
+            samples[k - 1][i] = float(value >> shift & 0xff);
+        }
+    }
+
+    edgeCoverage(inside, outside, samples, coverage);
+
+    return {float(cursorRect.x1) - coverage[0], float(cursorRect.y1) - coverage[1],
+            float(cursorRect.x2 + 2) + coverage[2], float(cursorRect.y2 + 2) + coverage[3]};
+}
+
+int Measurer::contrastShift(std::uint32_t inside, std::uint32_t outside)
+{
+    int shift{0};
+    int contrast{-1};
+
+    for (int channel = 0; channel < 24; channel += 8)
+    {
+        auto diff = std::abs(int(inside >> channel & 0xff) - int(outside >> channel & 0xff));
+
+        if (diff > contrast)
+        {
+            contrast = diff;
+            shift = channel;
+        }
+    }
+
+    return shift;
+}
+
+void Measurer::edgeCoverage(const float* inside, const float* outside,
+                            const float (*samples)[4], float* coverage)
+{
+#ifdef __SSE2__
+    const auto zero = _mm_setzero_ps();
+    const auto one = _mm_set1_ps(1.0f);
+    const auto out = _mm_loadu_ps(outside);
+    const auto range = _mm_sub_ps(_mm_loadu_ps(inside), out);
+    const auto isContrasted = _mm_cmpge_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), range),
+                                           _mm_set1_ps(float(kSubpixelContrast)));
+    auto sum = zero;
+
+    for (int k = 0; k < kSubpixelWindow - 1; ++k)
+    {
+        auto fraction = _mm_div_ps(_mm_sub_ps(_mm_loadu_ps(samples[k]), out), range);
+        sum = _mm_add_ps(sum, _mm_min_ps(_mm_max_ps(fraction, zero), one));
+    }
+
+    _mm_storeu_ps(coverage, _mm_and_ps(sum, isContrasted));
+#else
+    for (int i = 0; i < 4; ++i)
+    {
+        auto range = inside[i] - outside[i];
+        coverage[i] = 0;
+
+        if (std::abs(range) < kSubpixelContrast)
+        {
+            continue;
+        }
+
+        for (int k = 0; k < kSubpixelWindow - 1; ++k)
+        {
+            coverage[i] += std::min(std::max((samples[k][i] - outside[i]) / range, 0.0f), 1.0f);
+        }
+    }
+#endif
+}
+
+std::uint32_t Measurer::pixel(const Point& pos, const PixelView& view)
+{
+    auto p = view.pixel(pos.x, pos.y);
+
+    switch (view.format)
+    {
+    case PixelFormat::RGB32: return Rgb32Pixel::read(p);
+    case PixelFormat::ARGB32:
+    case PixelFormat::ARGB32Premultiplied: return Argb32Pixel::read(p);
+    case PixelFormat::RGB888: return Rgb888Pixel::read(p);
+    case PixelFormat::RGB16: return Rgb16Pixel::read(p);
+    case PixelFormat::Grayscale8: return Grayscale8Pixel::read(p);
+    }
+
+    return 0;
+}
+
+int Measurer::beamTo(int startPos, int endPos, int coord, int step,
+                     Orientation orientation, std::uint32_t color, const PixelView& view)
+{
+    switch (view.format)
+    {
+    case PixelFormat::RGB32:
+        return beamToFor<Rgb32Pixel>(startPos, endPos, coord, step, orientation, color, view);
+    case PixelFormat::ARGB32:
+    case PixelFormat::ARGB32Premultiplied:
+        return beamToFor<Argb32Pixel>(startPos, endPos, coord, step, orientation, color, view);
+    case PixelFormat::RGB888:
+        return beamToFor<Rgb888Pixel>(startPos, endPos, coord, step, orientation, color, view);
+    case PixelFormat::RGB16:
+        return beamToFor<Rgb16Pixel>(startPos, endPos, coord, step, orientation, color, view);
+    case PixelFormat::Grayscale8:
+        return beamToFor<Grayscale8Pixel>(startPos, endPos, coord, step, orientation, color, view);
+    }
+
+    return endPos;
+}
+
+template<typename Pixel>
+Rect Measurer::cursorRectangleFor(const Point& pos, const PixelView& view)
+{
+    if (!view.isNull() &&
+        pos.x >= 0 && pos.x < view.width &&
+        pos.y >= 0 && pos.y < view.height)
+    {
+        auto x = pos.x;
+        auto y = pos.y;
+        auto color = Pixel::read(view.data + y * view.stride + x * Pixel::kBytes);
+        auto cr = beamToFor<Pixel>(x, view.width - 1, y, 1, Orientation::Horizontal, color, view);
+        auto cl = beamToFor<Pixel>(x, 0, y, -1, Orientation::Horizontal, color, view);
+        auto cb = beamToFor<Pixel>(y, view.height - 1, x, 1, Orientation::Vertical, color, view);
+        auto ct = beamToFor<Pixel>(y, 0, x, -1, Orientation::Vertical, color, view);
+
+        return Rect::fromSize(cl, ct, cr - cl, cb - ct);
+    }
+
+    return {};
+}
+
+template<typename Pixel>
+int Measurer::beamToFor(int startPos, int endPos, int coord, int step,
+                        Orientation orientation, std::uint32_t color, const PixelView& view)
+{
+    auto isHorizontal = orientation == Orientation::Horizontal;
+    auto length = isHorizontal ? view.width : view.height;
+    auto breadth = isHorizontal ? view.height : view.width;
+
+    if (view.isNull() || coord < 0 || coord >= breadth)
+    {
+        return endPos;
+    }
+
+    const auto target = Pixel::normalize(color);
+    const auto base = isHorizontal ? view.data + coord * view.stride
+                                   : view.data + coord * std::ptrdiff_t(Pixel::kBytes);
+    const auto pitch = isHorizontal ? std::ptrdiff_t(Pixel::kBytes) : view.stride;
+
+    if (step > 0)
+    {
+        auto last = endPos > startPos ? std::min(endPos - 1, length - 1) : length - 1;
+
+        for (int pos = std::max(startPos + 1, 0); pos <= last; ++pos)
+        {
+            if (Pixel::read(base + pos * pitch) != target)
+            {
+                return pos - 1;
+            }
+        }
+    }
+    else
+    {
+        auto last = endPos < startPos ? std::max(endPos + 1, 0) : 0;
+
+        for (int pos = std::min(startPos - 1, length - 1); pos >= last; --pos)
+        {
+            if (Pixel::read(base + pos * pitch) != target)
+            {
+                return pos + 1;
+            }
+        }
+    }
+
+    return endPos;
+}
+
+} // namespace spm
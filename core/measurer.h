@@ -0,0 +1,44 @@
+#ifndef MEASURER_H
+#define MEASURER_H
+
+#include <array>
+#include <cstdint>
+
+#include "geometry.h"
+#include "pixelview.h"
+
+namespace spm {
+
+class Measurer
+{
+public:
+    static const int kSubpixelWindow{4};
+    static const int kSubpixelContrast{16};
+
+    static Rect cursorRectangle(const Point& pos, const PixelView& view);
+    static std::array<Line, 2> cursorLines(const Point& pos, const Rect& cursorRect);
+    static std::array<Line, 4> fixedLines(const Rect& fixedRect, int width, int height);
+    static std::array<Line, 2> measureLines(const Rect& cursorRect, const Rect& fixedRect);
+    // Edges on pixel boundaries, each moved out by the coverage of the blended pixels past it.
+    static RectF subpixelRectangle(const Point& pos, const Rect& cursorRect, const PixelView& view);
+
+    static std::uint32_t pixel(const Point& pos, const PixelView& view);
+    static int beamTo(int startPos, int endPos, int coord, int step,
+                      Orientation orientation, std::uint32_t color, const PixelView& view);
+
+private:
+    static int contrastShift(std::uint32_t inside, std::uint32_t outside);
+    static void edgeCoverage(const float* inside, const float* outside,
+                             const float (*samples)[4], float* coverage);
+
+    template<typename Pixel>
+    static Rect cursorRectangleFor(const Point& pos, const PixelView& view);
+
+    template<typename Pixel>
+    static int beamToFor(int startPos, int endPos, int coord, int step,
+                         Orientation orientation, std::uint32_t color, const PixelView& view);
+};
+
+} // namespace spm
+
+#endif // MEASURER_H
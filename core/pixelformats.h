@@ -0,0 +1,87 @@
+#ifndef PIXELFORMATS_H
+#define PIXELFORMATS_H
+
+#include <cstdint>
+#include <cstring>
+
+namespace spm {
+
+struct Rgb32Pixel {
+    static const int kBytes{4};
+
+    static std::uint32_t normalize(std::uint32_t value)
+    {
+        return value & 0x00ffffffu;
+    }
+
+    static std::uint32_t read(const std::uint8_t* p)
+    {
+        std::uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value & 0x00ffffffu;
+    }
+};
+
+struct Argb32Pixel {
+    static const int kBytes{4};
+
+    static std::uint32_t normalize(std::uint32_t value)
+    {
+        return value;
+    }
+
+    static std::uint32_t read(const std::uint8_t* p)
+    {
+        std::uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+};
+
+struct Rgb888Pixel {
+    static const int kBytes{3};
+
+    static std::uint32_t normalize(std::uint32_t value)
+    {
+        return value & 0x00ffffffu;
+    }
+
+    static std::uint32_t read(const std::uint8_t* p)
+    {
+        return std::uint32_t(p[0]) | std::uint32_t(p[1]) << 8 | std::uint32_t(p[2]) << 16;
+    }
+};
+
+struct Rgb16Pixel {
+    static const int kBytes{2};
+
+    static std::uint32_t normalize(std::uint32_t value)
+    {
+        return value & 0xffffu;
+    }
+
+    static std::uint32_t read(const std::uint8_t* p)
+    {
+        std::uint16_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+};
+
+struct Grayscale8Pixel {
+    static const int kBytes{1};
+
+    static std::uint32_t normalize(std::uint32_t value)
+    {
+        return value & 0xffu;
+    }
+
+    static std::uint32_t read(const std::uint8_t* p)
+    {
+        return *p;
+    }
+};
+
+} // namespace spm
+
+#endif // PIXELFORMATS_H
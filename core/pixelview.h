@@ -0,0 +1,46 @@
+#ifndef PIXELVIEW_H
+#define PIXELVIEW_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace spm {
+
+enum class PixelFormat {
+    RGB32,
+    ARGB32,
+    ARGB32Premultiplied,
+    RGB888,
+    RGB16,
+    Grayscale8
+};
+
+struct PixelView {
+    const std::uint8_t* data{nullptr};
+    std::ptrdiff_t stride{0};
+    int width{0};
+    int height{0};
+    PixelFormat format{PixelFormat::RGB32};
+
+    bool isNull() const { return !data || width <= 0 || height <= 0; }
+
+    int bytesPerPixel() const
+    {
+        switch (format)
+        {
+        case PixelFormat::RGB888: return 3;
+        case PixelFormat::RGB16: return 2;
+        case PixelFormat::Grayscale8: return 1;
+        default: return 4;
+        }
+    }
+
+    const std::uint8_t* pixel(int x, int y) const
+    {
+        return data + y * stride + x * bytesPerPixel();
+    }
+};
+
+} // namespace spm
+
+#endif // PIXELVIEW_H
@@ -0,0 +1,196 @@
+#include <QtConcurrent>
+#include <numeric>
+
+#include "alignmentmap.h"
+
+constexpr int AlignmentMap::kMinEdgeLength;
+constexpr int AlignmentMap::kBandSize;
+
+AlignmentMap::AlignmentMap()
+{
+}
+
+AlignmentMap AlignmentMap::build(const QImage& img)
+{
+    AlignmentMap alignmentMap;
+
+    if (img.isNull())
+    {
+        return alignmentMap;
+    }
+
+    const auto& src = img.depth() == 32 ? img : img.convertToFormat(QImage::Format_RGB32);
+
+    alignmentMap.m_size = src.size();
+    alignmentMap.m_columns = buildEdges(src, Qt::Vertical);
+    alignmentMap.m_rows = buildEdges(src, Qt::Horizontal);
+
+    return alignmentMap;
+}
+
+bool AlignmentMap::isNull() const
+{
+    return m_size.isEmpty();
+}
+
+QSize AlignmentMap::size() const
+{
+    return m_size;
+}
+
+int AlignmentMap::edgeLength(int boundary, Qt::Orientation orientation) const
+{
+    const auto& edges = orientation == Qt::Vertical ? m_columns : m_rows;
+
+    if (boundary < 0 || boundary >= int(edges.lengths.size()))
+    {
+        return 0;
+    }
+
+    return edges.lengths[size_t(boundary)];
+}
+
+void AlignmentMap::alignedEdges(const QRect& rect, int tolerance, QVector<QLine>& lines) const
+{
+    lines.clear();
+
+    if (isNull())
+    {
+        return;
+    }
+
+    auto left = rect.x();
+    auto top = rect.y();
+    auto right = rect.x() + rect.width();
+    auto bottom = rect.y() + rect.height();
+
+    appendAligned(lines, m_columns, left, left, tolerance, top, bottom, Qt::Vertical);
+    appendAligned(lines, m_columns, right + 1, right, tolerance, top, bottom, Qt::Vertical);
+    appendAligned(lines, m_rows, top, top, tolerance, left, right, Qt::Horizontal);
+    appendAligned(lines, m_rows, bottom + 1, bottom, tolerance, left, right, Qt::Horizontal);
+}
+
+AlignmentMap::Edges AlignmentMap::buildEdges(const QImage& img, Qt::Orientation orientation)
+{
+    const QRgb mask = img.hasAlphaChannel() ? 0xffffffff : 0x00ffffff;
+    auto isVertical = orientation == Qt::Vertical;
+    auto boundaries = isVertical ? img.width() : img.height();
+    auto length = isVertical ? img.height() : img.width();
+    std::vector<std::vector<std::vector<Segment>>> bands(size_t((boundaries + kBandSize - 1) / kBandSize));
+    QVector<int> indexes(int(bands.size()));
+    std::iota(indexes.begin(), indexes.end(), 0);
+
+    QtConcurrent::blockingMap(indexes, [&](int band){
+        auto first = band * kBandSize;
+        auto count = qMin(kBandSize, boundaries - first);
+        auto& segments = bands[size_t(band)];
+        std::vector<int> starts(size_t(count), -1);
+
+        segments.resize(size_t(count));
+
+        auto close = [&](int i, int pos){
+            if (starts[size_t(i)] >= 0 && pos - starts[size_t(i)] >= kMinEdgeLength)
+            {
+                segments[size_t(i)].push_back({starts[size_t(i)], pos - 1});
+            }
+
+            starts[size_t(i)] = -1;
+        };
+
+        auto track = [&](int i, int pos, bool isEdge){
+            if (!isEdge)
+            {
+                close(i, pos);
+            }
+            else if (starts[size_t(i)] < 0)
+            {
+                starts[size_t(i)] = pos;
+            }
+        };
+
+        if (isVertical)
+        {
+            for (int pos = 0; pos < length; ++pos)
+            {
+                auto line = reinterpret_cast<const QRgb*>(img.constScanLine(pos));
+
+                for (int i = first ? 0 : 1; i < count; ++i)
+                {
+                    track(i, pos, (line[first + i - 1] ^ line[first + i]) & mask);
+                }
+            }
+        }
+        else
+        {
+            for (int i = first ? 0 : 1; i < count; ++i)
+            {
+                auto before = reinterpret_cast<const QRgb*>(img.constScanLine(first + i - 1));
+                auto after = reinterpret_cast<const QRgb*>(img.constScanLine(first + i));
+
+                for (int pos = 0; pos < length; ++pos)
+                {
+                    track(i, pos, (before[pos] ^ after[pos]) & mask);
+                }
+            }
+        }
+
+        for (int i = 0; i < count; ++i)
+        {
+            close(i, length);
+        }
+    });
+
+    return mergeBands(bands, boundaries);
+}
+
+AlignmentMap::Edges AlignmentMap::mergeBands(std::vector<std::vector<std::vector<Segment>>>& bands, int boundaries)
+{
+    Edges edges;
+    edges.offsets.reserve(size_t(boundaries) + 1);
+    edges.lengths.reserve(size_t(boundaries));
+    edges.offsets.push_back(0);
+
+    for (auto& band : bands)
+    {
+        for (auto& segments : band)
+        {
+            auto length = 0;
+
+            for (const auto& segment : segments)
+            {
+                length += segment.end - segment.start + 1;
+            }
+
+            edges.segments.insert(edges.segments.end(), segments.begin(), segments.end());
+            edges.offsets.push_back(int(edges.segments.size()));
+            edges.lengths.push_back(length);
+        }
+    }
+
+    return edges;
+}
+
+void AlignmentMap::appendAligned(QVector<QLine>& lines, const Edges& edges, int boundary, int pos, int tolerance,
+                                 int spanStart, int spanEnd, Qt::Orientation orientation) const
+{
+    auto count = int(edges.lengths.size());
+
+    for (auto b = qMax(1, boundary - tolerance); b <= qMin(count - 1, boundary + tolerance); ++b)
+    {
+        auto coord = pos + b - boundary;
+
+        for (auto i = edges.offsets[size_t(b)]; i < edges.offsets[size_t(b) + 1]; ++i)
+        {
+            const auto& segment = edges.segments[size_t(i)];
+
+            if (b == boundary && segment.start <= spanEnd && segment.end >= spanStart)
+            {
+                continue;
+            }
+
+            lines.push_back(orientation == Qt::Vertical
+                            ? QLine{coord, segment.start, coord, segment.end}
+                            : QLine{segment.start, coord, segment.end, coord});
+        }
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef ALIGNMENTMAP_H
+#define ALIGNMENTMAP_H
+
+#include <QImage>
+#include <QLine>
+#include <QVector>
+#include <vector>
+
+class AlignmentMap
+{
+public:
+    static constexpr int kMinEdgeLength{8};
+    static constexpr int kBandSize{64};
+
+    AlignmentMap();
+
+    static AlignmentMap build(const QImage& img);
+
+    bool isNull() const;
+    QSize size() const;
+    int edgeLength(int boundary, Qt::Orientation orientation) const;
+    void alignedEdges(const QRect& rect, int tolerance, QVector<QLine>& lines) const;
+
+private:
+    struct Segment {
+        int start;
+        int end;
+    };
+
+    struct Edges {
+        std::vector<Segment> segments;
+        std::vector<int> offsets;
+        std::vector<int> lengths;
+    };
+
+    QSize m_size;
+    Edges m_columns;
+    Edges m_rows;
+
+private:
+    static Edges buildEdges(const QImage& img, Qt::Orientation orientation);
+    static Edges mergeBands(std::vector<std::vector<std::vector<Segment>>>& bands, int boundaries);
+    void appendAligned(QVector<QLine>& lines, const Edges& edges, int boundary, int pos, int tolerance,
+                       int spanStart, int spanEnd, Qt::Orientation orientation) const;
+};
+
+#endif // ALIGNMENTMAP_H
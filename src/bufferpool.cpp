@@ -0,0 +1,136 @@
+#include <QMutex>
+#include <cstdlib>
+#include <vector>
+
+#include "bufferpool.h"
+#include "profiler.h"
+
+const int BufferPool::kMaxFreeBuffers;
+
+namespace {
+struct Buffer {
+    uchar* data{nullptr};
+    qint64 size{0};
+};
+
+struct Pool {
+    QMutex mutex;
+    std::vector<Buffer*> free;
+    qint64 reuseCount{0};
+};
+
+Q_GLOBAL_STATIC(Pool, pool)
+}
+
+QImage BufferPool::image(const QSize& size, QImage::Format format)
+{
+    if (size.isEmpty())
+    {
+        return {};
+    }
+
+    auto depth = int(QImage::toPixelFormat(format).bitsPerPixel());
+    auto bytesPerLine = ((size.width() * depth + 31) / 32) * 4;
+    auto bytes = qint64(bytesPerLine) * size.height();
+    Buffer* buffer{nullptr};
+
+    {
+        QMutexLocker locker(&pool->mutex);
+        auto& free = pool->free;
+
+        for (auto it = free.begin(); it != free.end(); ++it)
+        {
+            if ((*it)->size == bytes)
+            {
+                buffer = *it;
+                free.erase(it);
+                ++pool->reuseCount;
+                break;
+            }
+        }
+
+        if (!buffer)
+        {
+            for (auto stale : free)
+            {
+                std::free(stale->data);
+                delete stale;
+            }
+
+            free.clear();
+        }
+    }
+
+    if (!buffer)
+    {
+        auto data = static_cast<uchar*>(std::malloc(size_t(bytes)));
+
+        if (!data)
+        {
+            return {};
+        }
+
+        buffer = new Buffer;
+        buffer->data = data;
+        buffer->size = bytes;
+        Profiler::countBufferAllocation(bytes);
+    }
+
+    return QImage(buffer->data, size.width(), size.height(), bytesPerLine, format,
+                  &BufferPool::release, buffer);
+}
+
+qint64 BufferPool::reuseCount()
+{
+    QMutexLocker locker(&pool->mutex);
+    return pool->reuseCount;
+}
+
+qint64 BufferPool::freeBytes()
+{
+    QMutexLocker locker(&pool->mutex);
+    qint64 bytes{0};
+
+    for (auto buffer : pool->free)
+    {
+        bytes += buffer->size;
+    }
+
+    return bytes;
+}
+
+void BufferPool::clear()
+{
+    QMutexLocker locker(&pool->mutex);
+
+    for (auto buffer : pool->free)
+    {
+        std::free(buffer->data);
+        delete buffer;
+    }
+
+    pool->free.clear();
+}
+
+void BufferPool::release(void* info)
+{
+    auto buffer = static_cast<Buffer*>(info);
+
+    if (pool.isDestroyed())
+    {
+        std::free(buffer->data);
+        delete buffer;
+        return;
+    }
+
+    QMutexLocker locker(&pool->mutex);
+
+    if (int(pool->free.size()) >= kMaxFreeBuffers)
+    {
+        std::free(pool->free.front()->data);
+        delete pool->free.front();
+        pool->free.erase(pool->free.begin());
+    }
+
+    pool->free.push_back(buffer);
+}
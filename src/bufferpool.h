@@ -0,0 +1,20 @@
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#include <QImage>
+
+class BufferPool
+{
+public:
+    static const int kMaxFreeBuffers{8};
+
+    static QImage image(const QSize& size, QImage::Format format);
+    static qint64 reuseCount();
+    static qint64 freeBytes();
+    static void clear();
+
+private:
+    static void release(void* info);
+};
+
+#endif // BUFFERPOOL_H
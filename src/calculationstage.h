@@ -0,0 +1,55 @@
+#ifndef CALCULATIONSTAGE_H
+#define CALCULATIONSTAGE_H
+
+#include <QtGlobal>
+#include <tuple>
+
+struct StageCounters {
+    const char* name;
+    qint64 hits;
+    qint64 misses;
+};
+
+// Remembers the inputs a stage was last calculated from; the stage reruns only when they change.
+template<typename... Inputs>
+class CalculationStage
+{
+public:
+    explicit CalculationStage(const char* name) : m_name(name) {}
+
+    bool isCurrent(const Inputs&... inputs)
+    {
+        auto current = std::make_tuple(inputs...);
+
+        if (m_isValid && current == m_inputs)
+        {
+            ++m_hits;
+            return true;
+        }
+
+        m_inputs = current;
+        m_isValid = true;
+        ++m_misses;
+
+        return false;
+    }
+
+    void invalidate()
+    {
+        m_isValid = false;
+    }
+
+    StageCounters counters() const
+    {
+        return {m_name, m_hits, m_misses};
+    }
+
+private:
+    const char* m_name;
+    std::tuple<Inputs...> m_inputs;
+    bool m_isValid{false};
+    qint64 m_hits{0};
+    qint64 m_misses{0};
+};
+
+#endif // CALCULATIONSTAGE_H
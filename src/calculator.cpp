@@ -1,4 +1,18 @@
+#include <QtConcurrent>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "calculator.h"
+#include "bufferpool.h"
+
+namespace {
+const QRect kNoContainer{0, 0, -1, -1};
+}
 
 Calculator::Calculator()
 {
@@ -14,17 +28,51 @@ QColor Calculator::calculateCursorColor(const QPoint& pos, const QImage& img)
     return {};
 }
 
+QColor Calculator::calculateCursorColor(const QPoint& pos, const TiledImage& img)
+{
+    if (img.rect().contains(pos))
+    {
+        return img.pixel(pos);
+    }
+
+    return {};
+}
+
 QRect Calculator::calculateCursorRectangle(const QPoint& pos, const QImage& img)
+{
+    return fromRect(spm::Measurer::cursorRectangle(toPoint(pos), toPixelView(img)));
+}
+
+QRect Calculator::calculateCursorRectangle(const QPoint& pos, const EdgeMap& edgeMap)
+{
+    auto size = edgeMap.size();
+
+    if (QRect({0, 0}, size).contains(pos))
+    {
+        auto x = pos.x();
+        auto y = pos.y();
+        auto cr = edgeMap.beamTo(x, size.width() - 1, y, 1, Qt::Horizontal);
+        auto cl = edgeMap.beamTo(x, 0, y, -1, Qt::Horizontal);
+        auto cb = edgeMap.beamTo(y, size.height() - 1, x, 1, Qt::Vertical);
+        auto ct = edgeMap.beamTo(y, 0, x, -1, Qt::Vertical);
+
+        return {cl, ct, cr - cl, cb - ct};
+    }
+
+    return {};
+}
+
+QRect Calculator::calculateCursorRectangle(const QPoint& pos, const TiledImage& img)
 {
     if (img.rect().contains(pos))
     {
         auto x = pos.x();
         auto y = pos.y();
         auto color = img.pixel(pos);
-        auto cr = Calculator::beamTo(x, img.width() - 1, y, 1, Qt::Horizontal, color, img);
-        auto cl = Calculator::beamTo(x, 0, y, -1, Qt::Horizontal, color, img);
-        auto cb = Calculator::beamTo(y, img.height() - 1, x, 1, Qt::Vertical, color, img);
-        auto ct = Calculator::beamTo(y, 0, x, -1, Qt::Vertical, color, img);
+        auto cr = img.beamTo(x, img.size().width() - 1, y, 1, Qt::Horizontal, color);
+        auto cl = img.beamTo(x, 0, y, -1, Qt::Horizontal, color);
+        auto cb = img.beamTo(y, img.size().height() - 1, x, 1, Qt::Vertical, color);
+        auto ct = img.beamTo(y, 0, x, -1, Qt::Vertical, color);
 
         return {cl, ct, cr - cl, cb - ct};
     }
@@ -32,132 +80,679 @@ QRect Calculator::calculateCursorRectangle(const QPoint& pos, const QImage& img)
     return {};
 }
 
-std::array<QLine, 2> Calculator::calculateCursorLines(const QPoint& pos, const QRect& cursorRect)
+QRect Calculator::calculateCursorRectangle(const QPoint& pos, const QImage& img, CursorRun& run)
+{
+    auto view = toPixelView(img);
+
+    if (view.isNull())
+    {
+        return {};
+    }
+
+    auto color = img.rect().contains(pos) ? spm::Measurer::pixel(toPoint(pos), view) : 0;
+
+    return updateCursorRun(pos, img.size(), run,
+                           [&](int startPos, int endPos, int coord, int step, Qt::Orientation orientation){
+        return spm::Measurer::beamTo(startPos, endPos, coord, step, toOrientation(orientation), color, view);
+    });
+}
+
+QRect Calculator::calculateCursorRectangle(const QPoint& pos, const EdgeMap& edgeMap, CursorRun& run)
+{
+    return updateCursorRun(pos, edgeMap.size(), run,
+                           [&](int startPos, int endPos, int coord, int step, Qt::Orientation orientation){
+        return edgeMap.beamTo(startPos, endPos, coord, step, orientation);
+    });
+}
+
+QRect Calculator::calculateCursorRectangle(const QPoint& pos, const TiledImage& img, CursorRun& run)
+{
+    auto color = img.rect().contains(pos) ? img.pixel(pos) : 0;
+
+    return updateCursorRun(pos, img.size(), run,
+                           [&](int startPos, int endPos, int coord, int step, Qt::Orientation orientation){
+        return img.beamTo(startPos, endPos, coord, step, orientation, color);
+    });
+}
+
+template<typename BeamTo>
+QRect Calculator::updateCursorRun(const QPoint& pos, const QSize& size, CursorRun& run, BeamTo beamTo)
 {
-    int l, r, t, b;
+    if (!QRect({0, 0}, size).contains(pos))
+    {
+        run = {};
+        return {};
+    }
+
     auto x = pos.x();
     auto y = pos.y();
+    auto isRowKept = run.isValid && y == run.pos.y() &&
+            x >= run.left && x <= run.right && x > 0 && x < size.width() - 1;
+    auto isColumnKept = run.isValid && x == run.pos.x() &&
+            y >= run.top && y <= run.bottom && y > 0 && y < size.height() - 1;
 
-    cursorRect.getCoords(&l, &t, &r, &b);
+    if (!isRowKept)
+    {
+        run.right = beamTo(x, size.width() - 1, y, 1, Qt::Horizontal);
+        run.left = beamTo(x, 0, y, -1, Qt::Horizontal);
+    }
+
+    if (!isColumnKept)
+    {
+        run.bottom = beamTo(y, size.height() - 1, x, 1, Qt::Vertical);
+        run.top = beamTo(y, 0, x, -1, Qt::Vertical);
+    }
+
+    run.pos = pos;
+    run.isValid = true;
+
+    return {run.left, run.top, run.right - run.left, run.bottom - run.top};
+}
+
+std::array<QLine, 2> Calculator::calculateCursorLines(const QPoint& pos, const QRect& cursorRect)
+{
+    auto lines = spm::Measurer::cursorLines(toPoint(pos), toRect(cursorRect));
 
     return {
-        QLine{l, y, r + 1, y},
-        QLine{x, t, x, b + 1}
+        fromLine(lines[0]),
+        fromLine(lines[1])
     };
 }
 
 std::array<QLine, 4> Calculator::calculateFixedLines(const QRect& fixedRect, const QImage& img)
 {
-    int l, t, b, r;
-    auto w = img.width();
-    auto h = img.height();
-    fixedRect.getCoords(&l, &t, &r, &b);
+    return calculateFixedLines(fixedRect, img.size());
+}
+
+std::array<QLine, 4> Calculator::calculateFixedLines(const QRect& fixedRect, const QSize& size)
+{
+    auto lines = spm::Measurer::fixedLines(toRect(fixedRect), size.width(), size.height());
 
     return {
-        QLine{1, t, w - 1, t},
-        QLine{1, b + 1, w - 1, b + 1},
-        QLine{l, 1, l, h - 1},
-        QLine{r + 1, 1, r + 1, h - 1}
+        fromLine(lines[0]),
+        fromLine(lines[1]),
+        fromLine(lines[2]),
+        fromLine(lines[3])
     };
 }
 
 std::array<QLine, 2> Calculator::calculateMeasureLines(const QRect& cursorRect, const QRect& fixedRect)
 {
-    int fl, ft, fb, fr, cl, cr, ct, cb;
-    int hx1{1}, hx2{1}, hy1{1}, hy2{1};
-    int vx1{1}, vx2{1}, vy1{1}, vy2{1};
+    auto lines = spm::Measurer::measureLines(toRect(cursorRect), toRect(fixedRect));
+
+    return {
+        fromLine(lines[0]),
+        fromLine(lines[1])
+    };
+}
+
+QRectF Calculator::calculateSubpixelRectangle(const QPoint& pos, const QRect& cursorRect, const QImage& img)
+{
+    auto rect = spm::Measurer::subpixelRectangle(toPoint(pos), toRect(cursorRect), toPixelView(img));
+
+    return QRectF{QPointF{rect.x1, rect.y1}, QPointF{rect.x2, rect.y2}};
+}
+
+void Calculator::calculateContainers(const QRect& rect, const QImage& img, ContainerTree& tree,
+                                     int depth, QVector<QRect>& containers)
+{
+    auto view = toPixelView(img);
+
+    if (view.isNull())
+    {
+        return;
+    }
+
+    updateContainers(rect, img.size(), tree, depth, containers,
+                     [&](int x, int y){
+        return spm::Measurer::pixel({x, y}, view);
+    },
+                     [&](int startPos, int endPos, int coord, int step,
+                         Qt::Orientation orientation, quint32 color){
+        return spm::Measurer::beamTo(startPos, endPos, coord, step, toOrientation(orientation), color, view);
+    });
+}
+
+void Calculator::calculateContainers(const QRect& rect, const TiledImage& img, ContainerTree& tree,
+                                     int depth, QVector<QRect>& containers)
+{
+    updateContainers(rect, img.size(), tree, depth, containers,
+                     [&](int x, int y){
+        return img.pixel({x, y});
+    },
+                     [&](int startPos, int endPos, int coord, int step,
+                         Qt::Orientation orientation, QRgb color){
+        return img.beamTo(startPos, endPos, coord, step, orientation, color);
+    });
+}
+
+std::array<QLine, 4> Calculator::calculateInsetLines(const QRect& rect, const QRect& containerRect)
+{
+    auto cx = rect.x() + rect.width() / 2;
+    auto cy = rect.y() + rect.height() / 2;
+    auto right = rect.x() + rect.width();
+    auto bottom = rect.y() + rect.height();
 
-    cursorRect.getCoords(&cl, &ct, &cr, &cb);
-    fixedRect.getCoords(&fl, &ft, &fr, &fb);
+    return {{
+        QLine{containerRect.x(), cy, rect.x() - 1, cy},
+        QLine{cx, containerRect.y(), cx, rect.y() - 1},
+        QLine{right + 1, cy, containerRect.x() + containerRect.width(), cy},
+        QLine{cx, bottom + 1, cx, containerRect.y() + containerRect.height()}
+    }};
+}
+
+template<typename Pixel, typename BeamTo>
+void Calculator::updateContainers(const QRect& rect, const QSize& size, ContainerTree& tree, int depth,
+                                  QVector<QRect>& containers, Pixel pixel, BeamTo beamTo)
+{
+    auto current = rect;
 
-    auto ccx = cursorRect.center().x();
-    auto ccy = cursorRect.center().y();
-    auto fcx = fixedRect.center().x();
-    auto fcy = fixedRect.center().y();
+    containers.clear();
 
-    if (cursorRect != fixedRect)
+    while (containers.size() < qMin(depth, int(kMaxContainerDepth)))
     {
-        if (cursorRect.contains(fixedRect))
+        auto key = containerKey(current);
+        auto it = tree.parents.constFind(key);
+
+        if (it == tree.parents.constEnd())
         {
-            hx2 = fl - 1;   hy2 = fcy;      hx1 = cl;   hy1 = fcy;
-            vx2 = fcx;      vy2= ft - 1;    vx1 = fcx;  vy1 = ct;
+            it = tree.parents.insert(key, parentContainer(current, size, pixel, beamTo));
         }
-        else if (fixedRect.contains(cursorRect))
+
+        current = it.value();
+
+        if (current.width() < 0)
         {
-            hx2 = cl - 1;   hy2 = ccy;      hx1 =fl;    hy1 = ccy;
-            vx2 = ccx;      vy2 = ct - 1;   vx1 = ccx;  vy1 = ft;
+            break;
         }
-        else
-        {
-            vx1 = vx2 = ccx;
-            hy1 = hy2 = ccy;
 
-            if (cb < ft)
-            {
-                vy1 = cb + 2; vy2 = ft - 1;
-            }
-            else if (ct > fb)
-            {
-                vy1 = fb + 2; vy2 = ct - 1;
-            }
-            else
+        containers.push_back(current);
+    }
+}
+
+template<typename Pixel, typename BeamTo>
+QRect Calculator::parentContainer(const QRect& rect, const QSize& size, Pixel pixel, BeamTo beamTo)
+{
+    auto width = size.width();
+    auto height = size.height();
+    auto left = rect.x();
+    auto top = rect.y();
+    auto right = rect.x() + rect.width();
+    auto bottom = rect.y() + rect.height();
+
+    if (rect.width() < 0 || rect.height() < 0 ||
+        !QRect({0, 0}, size).contains(QRect{QPoint{left, top}, QPoint{right, bottom}}))
+    {
+        return kNoContainer;
+    }
+
+    auto reach = [&](int boundary, int endPos, int from, int to, int step, Qt::Orientation orientation){
+        auto isHorizontal = orientation == Qt::Horizontal;
+        auto center = (from + to) / 2;
+        auto color = isHorizontal ? pixel(boundary, center) : pixel(center, boundary);
+        auto result = boundary;
+
+        auto breadth = isHorizontal ? height : width;
+
+        for (auto coord : {center, from, to, from - 1, to + 1})
+        {
+            if (coord < 0 || coord >= breadth)
             {
-                if (ct < ft)
-                {
-                    vy1 = ct; vy2 = ft - 1;
-                }
-                else if (ct > ft)
-                {
-                     vy1 = ft; vy2 = ct - 1;
-                }
+                continue;
             }
 
-            if (cr < fl)
+            auto sample = isHorizontal ? pixel(boundary, coord) : pixel(coord, boundary);
+
+            if (sample == color)
             {
-                hx1 = cr + 2; hx2 = fl - 1;
+                auto pos = beamTo(boundary, endPos, coord, step, orientation, color);
+                result = step < 0 ? qMin(result, pos) : qMax(result, pos);
             }
-            else if (cl > fr)
+        }
+
+        return result;
+    };
+
+    while (left > 0 || top > 0 || right < width - 1 || bottom < height - 1)
+    {
+        auto parentLeft = left > 0 ? reach(left - 1, 0, top, bottom, -1, Qt::Horizontal) : left;
+        auto parentRight = right < width - 1 ? reach(right + 1, width - 1, top, bottom, 1, Qt::Horizontal) : right;
+        auto parentTop = top > 0 ? reach(top - 1, 0, left, right, -1, Qt::Vertical) : top;
+        auto parentBottom = bottom < height - 1 ? reach(bottom + 1, height - 1, left, right, 1, Qt::Vertical) : bottom;
+        auto growth = qMax(qMax(left - parentLeft, parentRight - right),
+                           qMax(top - parentTop, parentBottom - bottom));
+
+        left = parentLeft;
+        top = parentTop;
+        right = parentRight;
+        bottom = parentBottom;
+
+        if (growth > kContainerBorderWidth)
+        {
+            return {left, top, right - left, bottom - top};
+        }
+    }
+
+    return kNoContainer;
+}
+
+int Calculator::inkLine(const QRgb* line, int width, QRgb background, int* columns)
+{
+    int count{0};
+    int x{0};
+
+#ifdef __SSE2__
+    const auto tol = _mm_set1_epi8(char(kTextTolerance));
+    const auto rgbMask = _mm_set1_epi32(int(RGB_MASK));
+    const auto zero = _mm_setzero_si128();
+    const auto bg = _mm_set1_epi32(int(background));
+
+    for (; x + 4 <= width; x += 4)
+    {
+        auto c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(line + x));
+        auto diff = _mm_or_si128(_mm_subs_epu8(c, bg), _mm_subs_epu8(bg, c));
+        auto same = _mm_cmpeq_epi32(_mm_and_si128(_mm_subs_epu8(diff, tol), rgbMask), zero);
+        auto mask = _mm_movemask_ps(_mm_castsi128_ps(same));
+
+        if (mask == 0xf)
+        {
+            continue;
+        }
+
+        count += 4 - qPopulationCount(quint32(mask));
+
+        if (columns)
+        {
+            auto acc = _mm_loadu_si128(reinterpret_cast<const __m128i*>(columns + x));
+            acc = _mm_sub_epi32(acc, _mm_xor_si128(same, _mm_set1_epi32(-1)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(columns + x), acc);
+        }
+    }
+#endif
+
+    for (; x < width; ++x)
+    {
+        auto c = line[x];
+        auto isInk = qAbs(qRed(c) - qRed(background)) > kTextTolerance ||
+                     qAbs(qGreen(c) - qGreen(background)) > kTextTolerance ||
+                     qAbs(qBlue(c) - qBlue(background)) > kTextTolerance;
+
+        count += isInk;
+
+        if (columns)
+        {
+            columns[x] += isInk;
+        }
+    }
+
+    return count;
+}
+
+std::pair<int, int> Calculator::inkSpan(const int* profile, int size, int pos, int gap)
+{
+    auto start = -1;
+
+    for (int d = 0; d <= gap && start < 0; ++d)
+    {
+        if (pos - d >= 0 && profile[pos - d])
+        {
+            start = pos - d;
+        }
+        else if (pos + d < size && profile[pos + d])
+        {
+            start = pos + d;
+        }
+    }
+
+    if (start < 0)
+    {
+        return {-1, -1};
+    }
+
+    auto first = start;
+    auto last = start;
+
+    for (int i = start - 1, empty = 0; i >= 0 && empty <= gap; --i)
+    {
+        empty = profile[i] ? 0 : empty + 1;
+        first = profile[i] ? i : first;
+    }
+
+    for (int i = start + 1, empty = 0; i < size && empty <= gap; ++i)
+    {
+        empty = profile[i] ? 0 : empty + 1;
+        last = profile[i] ? i : last;
+    }
+
+    return {first, last};
+}
+
+ContainerKey Calculator::containerKey(const QRect& rect)
+{
+    return {quint64(quint32(rect.x())) << 32 | quint32(rect.y()),
+            quint64(quint32(rect.width())) << 32 | quint32(rect.height())};
+}
+
+TextRun Calculator::calculateTextRun(const QPoint& pos, const QImage& img)
+{
+    TextRun run;
+    auto window = QRect(pos.x() - kTextWindowWidth / 2, pos.y() - kTextWindowHeight / 2,
+                        kTextWindowWidth, kTextWindowHeight) & img.rect();
+
+    if (!window.contains(pos))
+    {
+        return run;
+    }
+
+    const auto& src = img.depth() == 32 ? img : img.copy(window).convertToFormat(QImage::Format_RGB32);
+    auto origin = img.depth() == 32 ? window.topLeft() : QPoint{0, 0};
+    auto width = window.width();
+    auto height = window.height();
+    auto line = [&](int y){
+        return reinterpret_cast<const QRgb*>(src.constScanLine(origin.y() + y)) + origin.x();
+    };
+
+    QRgb background{0};
+    int votes{0};
+
+    for (int y = 0; y < height; ++y)
+    {
+        auto pixels = line(y);
+
+        for (int x = 0; x < width; ++x)
+        {
+            auto color = pixels[x] & RGB_MASK;
+
+            if (!votes)
             {
-                hx1 = fr + 2; hx2 = cl - 1;
+                background = color;
             }
-            else
+
+            votes += color == background ? 1 : -1;
+        }
+    }
+
+    std::array<int, kTextWindowHeight> rows{};
+    std::array<int, kTextWindowWidth> columns{};
+    auto cx = pos.x() - window.x();
+    auto cy = pos.y() - window.y();
+
+    for (int y = 0; y < height; ++y)
+    {
+        rows[size_t(y)] = inkLine(line(y), width, background, nullptr);
+    }
+
+    auto band = inkSpan(rows.data(), height, cy, 0);
+
+    if (band.first < 0)
+    {
+        return run;
+    }
+
+    for (int y = band.first; y <= band.second; ++y)
+    {
+        inkLine(line(y), width, background, columns.data());
+    }
+
+    auto span = inkSpan(columns.data(), width, cx, band.second - band.first + 1);
+
+    if (span.first < 0)
+    {
+        return run;
+    }
+
+    for (int y = 0; y < height; ++y)
+    {
+        rows[size_t(y)] = inkLine(line(y) + span.first, span.second - span.first + 1, background, nullptr);
+    }
+
+    if (rows[size_t(cy)])
+    {
+        band = inkSpan(rows.data(), height, cy, 0);
+    }
+
+    auto baseline = band.second;
+    auto drop = 0;
+
+    for (int y = (band.first + band.second + 1) / 2; y <= band.second; ++y)
+    {
+        auto next = y < band.second ? rows[size_t(y + 1)] : 0;
+
+        if (rows[size_t(y)] - next > drop)
+        {
+            drop = rows[size_t(y)] - next;
+            baseline = y;
+        }
+    }
+
+    run.rect = {window.x() + span.first, window.y() + band.first,
+                span.second - span.first, band.second - band.first};
+    run.baseline = window.y() + baseline;
+    run.isValid = true;
+
+    return run;
+}
+
+quint32 Calculator::calculateTransitionCount(const QRect& rect, const TransitionTable& table)
+{
+    QRect pixels{QPoint{rect.x(), rect.y()}, QPoint{rect.x() + rect.width(), rect.y() + rect.height()}};
+
+    return table.horizontalCount(pixels) + table.verticalCount(pixels);
+}
+
+bool Calculator::isUniform(const QRect& rect, const TransitionTable& table)
+{
+    return calculateTransitionCount(rect, table) == 0;
+}
+
+ClearanceMap Calculator::calculateClearanceMap(const QImage& img)
+{
+    ClearanceMap clearanceMap;
+    auto view = toPixelView(img);
+
+    if (view.isNull())
+    {
+        return clearanceMap;
+    }
+
+    const auto block = kClearanceBlock;
+    auto field = QSharedPointer<spm::DistanceField>::create();
+    field->reset(view.width, view.height);
+
+    QVector<int> columnBlocks((view.width + block - 1) / block);
+    std::iota(columnBlocks.begin(), columnBlocks.end(), 0);
+
+    QtConcurrent::blockingMap(columnBlocks, [&](int index){
+        field->computeColumns(view, index * block, qMin((index + 1) * block, view.width));
+    });
+
+    QVector<int> rowBlocks((view.height + block - 1) / block);
+    std::iota(rowBlocks.begin(), rowBlocks.end(), 0);
+
+    QtConcurrent::blockingMap(rowBlocks, [&](int index){
+        field->computeRows(index * block, qMin((index + 1) * block, view.height));
+    });
+
+    static const auto colors = []{
+        QVector<QRgb> colors;
+        const auto maxClearance = kMaxHeatmapClearance;
+
+        for (int squared = 0; squared <= maxClearance * maxClearance; ++squared)
+        {
+            auto hue = int(240 * qMin(std::sqrt(double(squared)) / maxClearance, 1.0));
+            colors.push_back(qPremultiply(QColor::fromHsv(hue, 255, 255, 0x80).rgba()));
+        }
+
+        return colors;
+    }();
+
+    auto heatmap = BufferPool::image({view.width, view.height}, QImage::Format_ARGB32_Premultiplied);
+    clearanceMap.field = field;
+    clearanceMap.image = img;
+
+    if (heatmap.isNull())
+    {
+        return clearanceMap;
+    }
+
+    auto bits = heatmap.bits();
+    auto bytesPerLine = heatmap.bytesPerLine();
+
+    QtConcurrent::blockingMap(rowBlocks, [&](int index){
+        for (int y = index * block; y < qMin((index + 1) * block, view.height); ++y)
+        {
+            auto line = reinterpret_cast<QRgb*>(bits + y * bytesPerLine);
+
+            for (int x = 0; x < view.width; ++x)
             {
-                if (cl < fl)
-                {
-                    hx1 = cl;  hx2 = fl - 1;
-                }
-                else if (cl > fl)
-                {
-                    hx1 = fl; hx2 = cl - 1;
-                }
+                auto squared = field->squaredDistance({x, y});
+                line[x] = colors[int(qMin<quint32>(squared, quint32(colors.size() - 1)))];
             }
         }
-    }
+    });
 
-    return {
-        QLine{vx1, vy1, vx2, vy2},
-        QLine{hx1, hy1, hx2, hy2}
-    };
+    clearanceMap.heatmap = heatmap;
+
+    return clearanceMap;
 }
 
-int Calculator::beamTo(int startPos, int endPos, int coord, int step,
-                       Qt::Orientation orientation, const QRgb& color, const QImage& img)
+QLine Calculator::calculateClearanceLine(const QPoint& pos, const ClearanceMap& clearanceMap)
 {
-    int resPos = endPos;
-    for (int pos = startPos + step; pos != endPos; pos += step)
+    if (!clearanceMap.field ||
+        clearanceMap.field->squaredDistance(toPoint(pos)) == spm::DistanceField::kInfinite)
+    {
+        return {};
+    }
+
+    auto nearest = clearanceMap.field->nearest(toPoint(pos));
+    const auto& img = clearanceMap.image;
+    auto color = img.pixel(pos);
+
+    if (img.pixel(nearest.x, nearest.y) != color)
+    {
+        return {pos.x(), pos.y(), nearest.x, nearest.y};
+    }
+
+    // The field is seeded from both sides of every edge, so the nearest seed may still
+    // have the cursor colour; the foreign pixel is its closest differently coloured neighbour.
+    QPoint foreign;
+    auto foreignDistance = std::numeric_limits<int>::max();
+
+    for (const auto& offset : {QPoint{-1, 0}, QPoint{1, 0}, QPoint{0, -1}, QPoint{0, 1}})
     {
-        auto point = orientation == Qt::Horizontal ? QPoint(pos, coord)
-                                                   : QPoint(coord, pos);
+        auto neighbour = QPoint{nearest.x, nearest.y} + offset;
 
-        if (!img.rect().contains(point))
+        if (!img.valid(neighbour) || img.pixel(neighbour) == color)
         {
-            break;
+            continue;
         }
 
-        if (img.pixel(point) != color)
+        auto distance = (neighbour - pos).manhattanLength();
+
+        if (distance < foreignDistance)
         {
-            return pos - step;
+            foreign = neighbour;
+            foreignDistance = distance;
         }
     }
-    return resPos;
+
+    if (foreignDistance == std::numeric_limits<int>::max())
+    {
+        return {};
+    }
+
+    return {pos, foreign};
+}
+
+int Calculator::beamTo(int startPos, int endPos, int coord, int step,
+                       Qt::Orientation orientation, const QRgb& color, const QImage& img)
+{
+    return spm::Measurer::beamTo(startPos, endPos, coord, step, toOrientation(orientation),
+                                 toPixelColor(color, img.format()), toPixelView(img));
+}
+
+QImage Calculator::toPixelViewImage(const QImage& img)
+{
+    return isPixelViewFormat(img.format()) ? img : img.convertToFormat(QImage::Format_RGB32);
+}
+
+bool Calculator::isPixelViewFormat(QImage::Format format)
+{
+    return format == QImage::Format_RGB32 ||
+           format == QImage::Format_ARGB32 ||
+           format == QImage::Format_ARGB32_Premultiplied ||
+           format == QImage::Format_RGB888 ||
+           format == QImage::Format_RGB16 ||
+           format == QImage::Format_Grayscale8;
+}
+
+quint32 Calculator::toPixelColor(QRgb color, QImage::Format format)
+{
+    switch (format)
+    {
+    case QImage::Format_RGB888:
+        return quint32(qRed(color)) | quint32(qGreen(color)) << 8 | quint32(qBlue(color)) << 16;
+    case QImage::Format_RGB16:
+        return quint32(qRed(color) & 0xf8) << 8 | quint32(qGreen(color) & 0xfc) << 3 | quint32(qBlue(color)) >> 3;
+    case QImage::Format_Grayscale8:
+        return quint32(qGray(color));
+    default:
+        return color;
+    }
+}
+
+spm::PixelView Calculator::toPixelView(const QImage& img)
+{
+    spm::PixelView view;
+
+    if (!isPixelViewFormat(img.format()))
+    {
+        return view;
+    }
+
+    view.data = img.constBits();
+    view.stride = img.bytesPerLine();
+    view.width = img.width();
+    view.height = img.height();
+
+    switch (img.format())
+    {
+    case QImage::Format_RGB32: view.format = spm::PixelFormat::RGB32; break;
+    case QImage::Format_ARGB32: view.format = spm::PixelFormat::ARGB32; break;
+    case QImage::Format_ARGB32_Premultiplied: view.format = spm::PixelFormat::ARGB32Premultiplied; break;
+    case QImage::Format_RGB888: view.format = spm::PixelFormat::RGB888; break;
+    case QImage::Format_RGB16: view.format = spm::PixelFormat::RGB16; break;
+    default: view.format = spm::PixelFormat::Grayscale8; break;
+    }
+
+    return view;
+}
+
+spm::Orientation Calculator::toOrientation(Qt::Orientation orientation)
+{
+    return orientation == Qt::Horizontal ? spm::Orientation::Horizontal
+                                         : spm::Orientation::Vertical;
+}
+
+spm::Point Calculator::toPoint(const QPoint& point)
+{
+    return {point.x(), point.y()};
+}
+
+spm::Rect Calculator::toRect(const QRect& rect)
+{
+    int x1, y1, x2, y2;
+    rect.getCoords(&x1, &y1, &x2, &y2);
+
+    return {x1, y1, x2, y2};
+}
+
+QRect Calculator::fromRect(const spm::Rect& rect)
+{
+    return QRect{QPoint{rect.x1, rect.y1}, QPoint{rect.x2, rect.y2}};
+}
+
+QLine Calculator::fromLine(const spm::Line& line)
+{
+    return {line.p1.x, line.p1.y, line.p2.x, line.p2.y};
 }
@@ -2,7 +2,45 @@
 #define CALCULATOR_H
 
 #include <QColor>
+#include <QHash>
+#include <QPair>
+#include <QVector>
 #include <QPixmap>
+#include <QSharedPointer>
+#include <array>
+
+#include "edgemap.h"
+#include "tiledimage.h"
+#include "transitiontable.h"
+#include "measurer.h"
+#include "distancefield.h"
+
+struct ClearanceMap {
+    QSharedPointer<spm::DistanceField> field;
+    QImage image;
+    QImage heatmap;
+};
+
+struct CursorRun {
+    QPoint pos;
+    int left{0};
+    int right{0};
+    int top{0};
+    int bottom{0};
+    bool isValid{false};
+};
+
+struct TextRun {
+    QRect rect;
+    int baseline{0};
+    bool isValid{false};
+};
+
+using ContainerKey = QPair<quint64, quint64>;
+
+struct ContainerTree {
+    QHash<ContainerKey, QRect> parents;
+};
 
 class Calculator
 {
@@ -10,13 +48,62 @@ public:
     Calculator();
 
     static QColor calculateCursorColor(const QPoint& pos, const QImage& img);
+    static QColor calculateCursorColor(const QPoint& pos, const TiledImage& img);
     static QRect calculateCursorRectangle(const QPoint& pos, const QImage& img);
+    static QRect calculateCursorRectangle(const QPoint& pos, const EdgeMap& edgeMap);
+    static QRect calculateCursorRectangle(const QPoint& pos, const TiledImage& img);
+    static QRect calculateCursorRectangle(const QPoint& pos, const QImage& img, CursorRun& run);
+    static QRect calculateCursorRectangle(const QPoint& pos, const EdgeMap& edgeMap, CursorRun& run);
+    static QRect calculateCursorRectangle(const QPoint& pos, const TiledImage& img, CursorRun& run);
     static std::array<QLine, 2> calculateCursorLines(const QPoint& pos, const QRect& cursorRect);
     static std::array<QLine, 4> calculateFixedLines(const QRect& fixedRect, const QImage& img);
+    static std::array<QLine, 4> calculateFixedLines(const QRect& fixedRect, const QSize& size);
     static std::array<QLine, 2> calculateMeasureLines(const QRect& cursorRect, const QRect& fixedRect);
+    static QRectF calculateSubpixelRectangle(const QPoint& pos, const QRect& cursorRect, const QImage& img);
+    static void calculateContainers(const QRect& rect, const QImage& img, ContainerTree& tree,
+                                    int depth, QVector<QRect>& containers);
+    static void calculateContainers(const QRect& rect, const TiledImage& img, ContainerTree& tree,
+                                    int depth, QVector<QRect>& containers);
+    static std::array<QLine, 4> calculateInsetLines(const QRect& rect, const QRect& containerRect);
+    static TextRun calculateTextRun(const QPoint& pos, const QImage& img);
+    static quint32 calculateTransitionCount(const QRect& rect, const TransitionTable& table);
+    static bool isUniform(const QRect& rect, const TransitionTable& table);
+    static ClearanceMap calculateClearanceMap(const QImage& img);
+    static QLine calculateClearanceLine(const QPoint& pos, const ClearanceMap& clearanceMap);
 
     static int beamTo(int startPos, int endPos, int coord, int step,
                       Qt::Orientation orientation, const QRgb& color, const QImage& img);
+
+    static const int kClearanceBlock{64};
+    static const int kMaxHeatmapClearance{64};
+    static const int kMaxContainerDepth{8};
+    static const int kContainerBorderWidth{2};
+    static const int kTextWindowWidth{512};
+    static const int kTextWindowHeight{128};
+    static const int kTextTolerance{8};
+
+    // QImage queries read the pixels in place; convert other formats once when the image is set.
+    static QImage toPixelViewImage(const QImage& img);
+    static bool isPixelViewFormat(QImage::Format format);
+    static quint32 toPixelColor(QRgb color, QImage::Format format);
+    static spm::PixelView toPixelView(const QImage& img);
+    static spm::Orientation toOrientation(Qt::Orientation orientation);
+    static spm::Point toPoint(const QPoint& point);
+    static spm::Rect toRect(const QRect& rect);
+    static QRect fromRect(const spm::Rect& rect);
+    static QLine fromLine(const spm::Line& line);
+
+private:
+    template<typename BeamTo>
+    static QRect updateCursorRun(const QPoint& pos, const QSize& size, CursorRun& run, BeamTo beamTo);
+    template<typename Pixel, typename BeamTo>
+    static void updateContainers(const QRect& rect, const QSize& size, ContainerTree& tree, int depth,
+                                 QVector<QRect>& containers, Pixel pixel, BeamTo beamTo);
+    template<typename Pixel, typename BeamTo>
+    static QRect parentContainer(const QRect& rect, const QSize& size, Pixel pixel, BeamTo beamTo);
+    static ContainerKey containerKey(const QRect& rect);
+    static int inkLine(const QRgb* line, int width, QRgb background, int* columns);
+    static std::pair<int, int> inkSpan(const int* profile, int size, int pos, int gap);
 };
 
 #endif // CALCULATOR_H
@@ -0,0 +1,228 @@
+#include <QtConcurrent>
+#include <QtAlgorithms>
+#include <QMutex>
+#include <numeric>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "colorstats.h"
+
+const int ColorStats::kHistogramBins;
+const int ColorStats::kBandHeight;
+
+namespace {
+struct ColorSet {
+    ColorSet() : words(1 << 18) {}
+
+    QMutex mutex;
+    QVector<QAtomicInteger<quint64>> words;
+};
+
+Q_GLOBAL_STATIC(ColorSet, colorSet)
+}
+
+ColorStats::ColorStats()
+{
+}
+
+ColorStats ColorStats::calculate(const QImage& img, const QRect& rect)
+{
+    ColorStats stats;
+    auto area = rect & img.rect();
+
+    stats.m_rect = rect;
+    stats.m_imageKey = img.cacheKey();
+
+    if (area.isEmpty())
+    {
+        return stats;
+    }
+
+    const auto& src = img.depth() == 32 ? img : img.copy(area).convertToFormat(QImage::Format_RGB32);
+    const auto origin = img.depth() == 32 ? area.topLeft() : QPoint{0, 0};
+    const auto bandHeight = kBandHeight;
+
+    QMutexLocker locker(&colorSet->mutex);
+    auto& colors = colorSet->words;
+    QVector<Partial> partials((area.height() + bandHeight - 1) / bandHeight);
+    QVector<int> bands(partials.size());
+    std::iota(bands.begin(), bands.end(), 0);
+
+    auto partialData = partials.data();
+    auto colorData = colors.data();
+
+    QtConcurrent::blockingMap(bands, [&](int band){
+        auto& partial = partialData[band];
+        auto top = band * bandHeight;
+        auto bottom = qMin(top + bandHeight, area.height());
+
+        for (int y = top; y < bottom; ++y)
+        {
+            auto line = reinterpret_cast<const QRgb*>(src.constScanLine(origin.y() + y)) + origin.x();
+
+            reduceLine(line, area.width(), partial);
+            countLine(line, area.width(), partial, colorData);
+        }
+    });
+
+    Partial total;
+
+    for (const auto& partial : partials)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            total.sum[c] += partial.sum[c];
+            total.minimum[c] = qMin(total.minimum[c], partial.minimum[c]);
+            total.maximum[c] = qMax(total.maximum[c], partial.maximum[c]);
+        }
+
+        for (int bin = 0; bin < kHistogramBins; ++bin)
+        {
+            total.histogram[bin] += partial.histogram[bin];
+        }
+    }
+
+    auto count = qint64(area.width()) * area.height();
+
+    stats.m_pixelCount = count;
+    stats.m_average = QColor(int((total.sum[0] + count / 2) / count),
+                             int((total.sum[1] + count / 2) / count),
+                             int((total.sum[2] + count / 2) / count));
+    stats.m_minimum = QColor(total.minimum[0], total.minimum[1], total.minimum[2]);
+    stats.m_maximum = QColor(total.maximum[0], total.maximum[1], total.maximum[2]);
+    stats.m_histogram = total.histogram;
+
+    for (auto& word : colors)
+    {
+        stats.m_uniqueCount += int(qPopulationCount(word.loadRelaxed()));
+        word.storeRelaxed(0);
+    }
+
+    return stats;
+}
+
+bool ColorStats::isNull() const
+{
+    return m_pixelCount == 0;
+}
+
+bool ColorStats::matches(const QImage& img, const QRect& rect) const
+{
+    return m_rect == rect && m_imageKey == img.cacheKey();
+}
+
+QRect ColorStats::rect() const
+{
+    return m_rect;
+}
+
+QColor ColorStats::average() const
+{
+    return m_average;
+}
+
+QColor ColorStats::minimum() const
+{
+    return m_minimum;
+}
+
+QColor ColorStats::maximum() const
+{
+    return m_maximum;
+}
+
+int ColorStats::uniqueCount() const
+{
+    return m_uniqueCount;
+}
+
+const std::array<qint64, ColorStats::kHistogramBins>& ColorStats::histogram() const
+{
+    return m_histogram;
+}
+
+void ColorStats::reduceLine(const QRgb* line, int width, Partial& partial)
+{
+    int x{0};
+
+#ifdef __SSE2__
+    const auto byteMask = _mm_set1_epi32(0xff);
+    auto minimum = _mm_set1_epi8(char(0xff));
+    auto maximum = _mm_setzero_si128();
+    auto red = _mm_setzero_si128();
+    auto green = _mm_setzero_si128();
+    auto blue = _mm_setzero_si128();
+
+    for (; x + 4 <= width; x += 4)
+    {
+        auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(line + x));
+
+        minimum = _mm_min_epu8(minimum, pixels);
+        maximum = _mm_max_epu8(maximum, pixels);
+        red = _mm_add_epi32(red, _mm_and_si128(_mm_srli_epi32(pixels, 16), byteMask));
+        green = _mm_add_epi32(green, _mm_and_si128(_mm_srli_epi32(pixels, 8), byteMask));
+        blue = _mm_add_epi32(blue, _mm_and_si128(pixels, byteMask));
+    }
+
+    if (x)
+    {
+        alignas(16) quint32 lanes[3][4];
+        alignas(16) quint8 bytes[2][16];
+
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes[0]), red);
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes[1]), green);
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes[2]), blue);
+        _mm_store_si128(reinterpret_cast<__m128i*>(bytes[0]), minimum);
+        _mm_store_si128(reinterpret_cast<__m128i*>(bytes[1]), maximum);
+
+        for (int c = 0; c < 3; ++c)
+        {
+            auto byte = 2 - c;
+
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                partial.sum[c] += lanes[c][lane];
+                partial.minimum[c] = qMin<int>(partial.minimum[c], bytes[0][lane * 4 + byte]);
+                partial.maximum[c] = qMax<int>(partial.maximum[c], bytes[1][lane * 4 + byte]);
+            }
+        }
+    }
+#endif
+
+    for (; x < width; ++x)
+    {
+        const int channels[3]{qRed(line[x]), qGreen(line[x]), qBlue(line[x])};
+
+        for (int c = 0; c < 3; ++c)
+        {
+            partial.sum[c] += quint64(channels[c]);
+            partial.minimum[c] = qMin(partial.minimum[c], channels[c]);
+            partial.maximum[c] = qMax(partial.maximum[c], channels[c]);
+        }
+    }
+}
+
+void ColorStats::countLine(const QRgb* line, int width, Partial& partial, QAtomicInteger<quint64>* colors)
+{
+    for (int x = 0; x < width;)
+    {
+        auto color = line[x] & 0x00ffffff;
+        auto start = x;
+
+        while (++x < width && (line[x] & 0x00ffffff) == color)
+        {
+        }
+
+        auto& word = colors[color >> 6];
+        auto bit = quint64(1) << (color & 63);
+
+        if (!(word.loadRelaxed() & bit))
+        {
+            word.fetchAndOrRelaxed(bit);
+        }
+
+        partial.histogram[size_t(qGray(color) * kHistogramBins / 256)] += x - start;
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef COLORSTATS_H
+#define COLORSTATS_H
+
+#include <QAtomicInteger>
+#include <QColor>
+#include <QImage>
+#include <array>
+
+class ColorStats
+{
+public:
+    static const int kHistogramBins{8};
+    static const int kBandHeight{32};
+
+    ColorStats();
+
+    static ColorStats calculate(const QImage& img, const QRect& rect);
+
+    bool isNull() const;
+    bool matches(const QImage& img, const QRect& rect) const;
+    QRect rect() const;
+    QColor average() const;
+    QColor minimum() const;
+    QColor maximum() const;
+    int uniqueCount() const;
+    const std::array<qint64, kHistogramBins>& histogram() const;
+
+private:
+    struct Partial {
+        std::array<quint64, 3> sum{{0, 0, 0}};
+        std::array<int, 3> minimum{{255, 255, 255}};
+        std::array<int, 3> maximum{{0, 0, 0}};
+        std::array<qint64, kHistogramBins> histogram{};
+    };
+
+    QRect m_rect;
+    qint64 m_imageKey{0};
+    qint64 m_pixelCount{0};
+    QColor m_average;
+    QColor m_minimum;
+    QColor m_maximum;
+    int m_uniqueCount{0};
+    std::array<qint64, kHistogramBins> m_histogram{};
+
+private:
+    static void reduceLine(const QRgb* line, int width, Partial& partial);
+    static void countLine(const QRgb* line, int width, Partial& partial, QAtomicInteger<quint64>* colors);
+};
+
+#endif // COLORSTATS_H
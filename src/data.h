@@ -2,7 +2,11 @@
 #define DATA_H
 
 #include <QColor>
-#include <QPixmap>
+#include <QImage>
+#include <QVector>
+
+#include "tiledimage.h"
+#include "colorstats.h"
 
 struct Palette {
     QColor background;
@@ -11,22 +15,47 @@ struct Palette {
     QColor cursorRectangle;
     QColor cursorLines;
     QColor measureLines;
+    QColor difference;
 };
 
 struct RenderData{
-    QPixmap screenImage;
+    QImage screenImage;
+    TiledImage tiledImage;
+    QImage referenceImage;
+    QImage diffImage;
+    QImage clearanceImage;
     QColor cursorColor;
     QPoint cursorPoint;
     QLine cursorHLine;
     QLine cursorVLine;
     QLine measureHLine;
     QLine measureVLine;
+    QLine clearanceLine;
+    QLine baselineLine;
     QRect cursorRectangle;
     QRect fixedRectangle;
+    QRect referenceRectangle;
+    QRect containerRectangle;
+    QRectF subpixelRectangle;
     std::array<QLine, 4> fixedLines;
+    std::array<QLine, 4> insetLines;
+    QVector<QLine> alignmentLines;
+    ColorStats colorStats;
+    double clearance{0};
+    int containerLevel{0};
+    int alignmentTolerance{0};
+    int fixedRectTransitions{-1};
     bool isMeasurerRectPresent{false};
     bool isCursorRectPresent{false};
     bool isFixedRectPresent{false};
+    bool isReferencePresent{false};
+    bool isClearancePresent{false};
+    bool isContainerPresent{false};
+    bool isTextMode{false};
+    bool isTextPresent{false};
+    bool isSubpixelMode{false};
+    bool isSubpixelPresent{false};
+    bool isAlignmentPresent{false};
     bool isItemDragging{false};
 };
 
@@ -0,0 +1,206 @@
+#include <QtConcurrent>
+#include <QtAlgorithms>
+#include <algorithm>
+#include <numeric>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "diffmap.h"
+#include "bufferpool.h"
+
+constexpr int DiffMap::kTileSize;
+
+DiffMap::DiffMap()
+{
+}
+
+DiffMap DiffMap::build(const QImage& capture, const QImage& reference, int tolerance, QRgb highlight)
+{
+    DiffMap diffMap;
+
+    if (capture.isNull() || reference.isNull())
+    {
+        return diffMap;
+    }
+
+    const auto& cap = capture.depth() == 32 ? capture : capture.convertToFormat(QImage::Format_RGB32);
+    const auto& ref = reference.depth() == 32 ? reference : reference.convertToFormat(QImage::Format_RGB32);
+    const auto tileSize = kTileSize;
+    const auto size = cap.size().boundedTo(ref.size());
+    const auto premultiplied = qPremultiply(highlight);
+    const auto faint = qPremultiply(qRgba(qRed(highlight), qGreen(highlight), qBlue(highlight), 0x40));
+
+    diffMap.m_size = size;
+    diffMap.m_columns = (size.width() + tileSize - 1) / tileSize;
+    diffMap.m_rows = (size.height() + tileSize - 1) / tileSize;
+    diffMap.m_dirtyTiles.assign(size_t(diffMap.m_columns) * diffMap.m_rows, 0);
+    diffMap.m_image = BufferPool::image(size, QImage::Format_ARGB32_Premultiplied);
+
+    if (diffMap.m_image.isNull())
+    {
+        return {};
+    }
+
+    auto bits = diffMap.m_image.bits();
+    auto bytesPerLine = diffMap.m_image.bytesPerLine();
+
+    QVector<int> bands(diffMap.m_rows);
+    std::iota(bands.begin(), bands.end(), 0);
+
+    QtConcurrent::blockingMap(bands, [&](int row){
+        auto top = row * tileSize;
+        auto bottom = qMin(top + tileSize, size.height());
+        auto dirty = &diffMap.m_dirtyTiles[size_t(row) * diffMap.m_columns];
+
+        for (int y = top; y < bottom; ++y)
+        {
+            auto capLine = reinterpret_cast<const QRgb*>(cap.constScanLine(y));
+            auto refLine = reinterpret_cast<const QRgb*>(ref.constScanLine(y));
+            auto outLine = reinterpret_cast<QRgb*>(bits + y * bytesPerLine);
+
+            for (int column = 0; column < diffMap.m_columns; ++column)
+            {
+                auto x = column * tileSize;
+                auto width = qMin(tileSize, size.width() - x);
+
+                if (compareLine(capLine + x, refLine + x, outLine + x, width, tolerance, premultiplied))
+                {
+                    dirty[column] = 1;
+                }
+            }
+        }
+
+        for (int column = 0; column < diffMap.m_columns; ++column)
+        {
+            if (!dirty[column])
+            {
+                continue;
+            }
+
+            auto x = column * tileSize;
+            auto width = qMin(tileSize, size.width() - x);
+
+            for (int y = top; y < bottom; ++y)
+            {
+                auto outLine = reinterpret_cast<QRgb*>(bits + y * bytesPerLine) + x;
+
+                for (int i = 0; i < width; ++i)
+                {
+                    if (!outLine[i])
+                    {
+                        outLine[i] = faint;
+                    }
+                }
+            }
+        }
+    });
+
+    diffMap.m_dirtyTileCount = int(std::count(diffMap.m_dirtyTiles.begin(), diffMap.m_dirtyTiles.end(), 1));
+
+    return diffMap;
+}
+
+bool DiffMap::isNull() const
+{
+    return m_size.isEmpty();
+}
+
+QSize DiffMap::size() const
+{
+    return m_size;
+}
+
+const QImage& DiffMap::image() const
+{
+    return m_image;
+}
+
+int DiffMap::dirtyTileCount() const
+{
+    return m_dirtyTileCount;
+}
+
+bool DiffMap::isTileDirty(int column, int row) const
+{
+    if (column < 0 || column >= m_columns || row < 0 || row >= m_rows)
+    {
+        return false;
+    }
+
+    return m_dirtyTiles[size_t(row) * m_columns + column];
+}
+
+QRect DiffMap::nextDifference(const QPoint& pos) const
+{
+    auto count = int(m_dirtyTiles.size());
+
+    if (!m_dirtyTileCount || !count)
+    {
+        return {};
+    }
+
+    auto column = qBound(0, pos.x() / kTileSize, m_columns - 1);
+    auto row = qBound(0, pos.y() / kTileSize, m_rows - 1);
+    auto start = row * m_columns + column;
+
+    for (int i = 1; i <= count; ++i)
+    {
+        auto index = (start + i) % count;
+
+        if (m_dirtyTiles[size_t(index)])
+        {
+            return tileRect(index);
+        }
+    }
+
+    return {};
+}
+
+QRect DiffMap::tileRect(int index) const
+{
+    QRect rect{(index % m_columns) * kTileSize, (index / m_columns) * kTileSize, kTileSize, kTileSize};
+
+    return rect & QRect({0, 0}, m_size);
+}
+
+int DiffMap::compareLine(const QRgb* capture, const QRgb* reference, QRgb* out,
+                         int width, int tolerance, QRgb highlight)
+{
+    int differences{0};
+    int x{0};
+
+#ifdef __SSE2__
+    const auto tol = _mm_set1_epi8(char(qBound(0, tolerance, 255)));
+    const auto rgbMask = _mm_set1_epi32(0x00ffffff);
+    const auto zero = _mm_setzero_si128();
+    const auto hl = _mm_set1_epi32(int(highlight));
+
+    for (; x + 4 <= width; x += 4)
+    {
+        auto c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(capture + x));
+        auto r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(reference + x));
+        auto diff = _mm_or_si128(_mm_subs_epu8(c, r), _mm_subs_epu8(r, c));
+        auto over = _mm_and_si128(_mm_subs_epu8(diff, tol), rgbMask);
+        auto same = _mm_cmpeq_epi32(over, zero);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_andnot_si128(same, hl));
+        differences += 4 - qPopulationCount(quint32(_mm_movemask_ps(_mm_castsi128_ps(same))));
+    }
+#endif
+
+    for (; x < width; ++x)
+    {
+        auto c = capture[x];
+        auto r = reference[x];
+        auto isDifferent = qAbs(qRed(c) - qRed(r)) > tolerance ||
+                           qAbs(qGreen(c) - qGreen(r)) > tolerance ||
+                           qAbs(qBlue(c) - qBlue(r)) > tolerance;
+
+        out[x] = isDifferent ? highlight : 0;
+        differences += isDifferent;
+    }
+
+    return differences;
+}
@@ -0,0 +1,37 @@
+#ifndef DIFFMAP_H
+#define DIFFMAP_H
+
+#include <QImage>
+#include <vector>
+
+class DiffMap
+{
+public:
+    static constexpr int kTileSize{32};
+
+    DiffMap();
+
+    static DiffMap build(const QImage& capture, const QImage& reference, int tolerance, QRgb highlight);
+
+    bool isNull() const;
+    QSize size() const;
+    const QImage& image() const;
+    int dirtyTileCount() const;
+    bool isTileDirty(int column, int row) const;
+    QRect nextDifference(const QPoint& pos) const;
+
+private:
+    QSize m_size;
+    QImage m_image;
+    int m_columns{0};
+    int m_rows{0};
+    int m_dirtyTileCount{0};
+    std::vector<char> m_dirtyTiles;
+
+private:
+    QRect tileRect(int index) const;
+    static int compareLine(const QRgb* capture, const QRgb* reference, QRgb* out,
+                           int width, int tolerance, QRgb highlight);
+};
+
+#endif // DIFFMAP_H
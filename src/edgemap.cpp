@@ -0,0 +1,187 @@
+#include <QtAlgorithms>
+
+#include "edgemap.h"
+
+EdgeMap::EdgeMap()
+{
+}
+
+EdgeMap EdgeMap::build(const QImage& img)
+{
+    EdgeMap edgeMap;
+
+    if (img.isNull())
+    {
+        return edgeMap;
+    }
+
+    const auto& src = img.depth() == 32 ? img : img.convertToFormat(QImage::Format_RGB32);
+    const QRgb mask = src.hasAlphaChannel() ? 0xffffffff : 0x00ffffff;
+    const int w = src.width();
+    const int h = src.height();
+    const int hWords = wordsPerLine(w);
+    const int vWords = wordsPerLine(h);
+
+    edgeMap.m_size = src.size();
+    edgeMap.m_horizontal.fill(0, hWords * h * int(sizeof(quint64)));
+    edgeMap.m_vertical.fill(0, vWords * w * int(sizeof(quint64)));
+
+    auto horizontal = reinterpret_cast<quint64*>(edgeMap.m_horizontal.data());
+    auto vertical = reinterpret_cast<quint64*>(edgeMap.m_vertical.data());
+
+    for (int y = 0; y < h; ++y)
+    {
+        auto line = reinterpret_cast<const QRgb*>(src.constScanLine(y));
+        auto nextLine = y + 1 < h ? reinterpret_cast<const QRgb*>(src.constScanLine(y + 1)) : nullptr;
+        auto hLine = horizontal + y * hWords;
+        const quint64 vBit = quint64(1) << (y % 64);
+
+        for (int x = 0; x < w; ++x)
+        {
+            if (x + 1 < w && ((line[x] ^ line[x + 1]) & mask))
+            {
+                hLine[x / 64] |= quint64(1) << (x % 64);
+            }
+
+            if (nextLine && ((line[x] ^ nextLine[x]) & mask))
+            {
+                vertical[x * vWords + y / 64] |= vBit;
+            }
+        }
+    }
+
+    return edgeMap;
+}
+
+EdgeMap EdgeMap::fromData(const QSize& size, const QByteArray& horizontal, const QByteArray& vertical)
+{
+    EdgeMap edgeMap;
+
+    if (size.isEmpty() ||
+        horizontal.size() != wordsPerLine(size.width()) * size.height() * int(sizeof(quint64)) ||
+        vertical.size() != wordsPerLine(size.height()) * size.width() * int(sizeof(quint64)))
+    {
+        return edgeMap;
+    }
+
+    edgeMap.m_size = size;
+    edgeMap.m_horizontal = horizontal;
+    edgeMap.m_vertical = vertical;
+
+    return edgeMap;
+}
+
+int EdgeMap::wordsPerLine(int length)
+{
+    return (length + 63) / 64;
+}
+
+bool EdgeMap::isNull() const
+{
+    return m_size.isEmpty();
+}
+
+QSize EdgeMap::size() const
+{
+    return m_size;
+}
+
+const QByteArray& EdgeMap::horizontalData() const
+{
+    return m_horizontal;
+}
+
+const QByteArray& EdgeMap::verticalData() const
+{
+    return m_vertical;
+}
+
+int EdgeMap::beamTo(int startPos, int endPos, int coord, int step, Qt::Orientation orientation) const
+{
+    auto length = orientation == Qt::Horizontal ? m_size.width() : m_size.height();
+    auto breadth = orientation == Qt::Horizontal ? m_size.height() : m_size.width();
+
+    if (coord < 0 || coord >= breadth)
+    {
+        return endPos;
+    }
+
+    auto words = line(coord, orientation);
+
+    if (step > 0)
+    {
+        auto edge = findNext(words, qMax(startPos, 0), qMin(endPos - 2, length - 2));
+        return edge < 0 ? endPos : edge;
+    }
+
+    auto edge = findPrev(words, qMin(startPos - 1, length - 2), qMax(endPos + 1, 0));
+    return edge < 0 ? endPos : edge + 1;
+}
+
+const quint64* EdgeMap::line(int coord, Qt::Orientation orientation) const
+{
+    if (orientation == Qt::Horizontal)
+    {
+        return reinterpret_cast<const quint64*>(m_horizontal.constData()) +
+                coord * wordsPerLine(m_size.width());
+    }
+
+    return reinterpret_cast<const quint64*>(m_vertical.constData()) +
+            coord * wordsPerLine(m_size.height());
+}
+
+int EdgeMap::findNext(const quint64* words, int from, int to)
+{
+    if (from > to)
+    {
+        return -1;
+    }
+
+    auto index = from / 64;
+    auto last = to / 64;
+    auto word = words[index] & (~quint64(0) << (from % 64));
+
+    while (true)
+    {
+        if (word)
+        {
+            auto pos = index * 64 + int(qCountTrailingZeroBits(word));
+            return pos <= to ? pos : -1;
+        }
+
+        if (++index > last)
+        {
+            return -1;
+        }
+
+        word = words[index];
+    }
+}
+
+int EdgeMap::findPrev(const quint64* words, int from, int to)
+{
+    if (from < to)
+    {
+        return -1;
+    }
+
+    auto index = from / 64;
+    auto last = to / 64;
+    auto word = words[index] & (~quint64(0) >> (63 - from % 64));
+
+    while (true)
+    {
+        if (word)
+        {
+            auto pos = index * 64 + 63 - int(qCountLeadingZeroBits(word));
+            return pos >= to ? pos : -1;
+        }
+
+        if (--index < last)
+        {
+            return -1;
+        }
+
+        word = words[index];
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef EDGEMAP_H
+#define EDGEMAP_H
+
+#include <QByteArray>
+#include <QImage>
+
+class EdgeMap
+{
+public:
+    static constexpr quint32 kVersion{1};
+
+    EdgeMap();
+
+    static EdgeMap build(const QImage& img);
+    static EdgeMap fromData(const QSize& size, const QByteArray& horizontal, const QByteArray& vertical);
+    static int wordsPerLine(int length);
+
+    bool isNull() const;
+    QSize size() const;
+    const QByteArray& horizontalData() const;
+    const QByteArray& verticalData() const;
+
+    int beamTo(int startPos, int endPos, int coord, int step, Qt::Orientation orientation) const;
+
+private:
+    QSize m_size;
+    QByteArray m_horizontal;
+    QByteArray m_vertical;
+
+private:
+    const quint64* line(int coord, Qt::Orientation orientation) const;
+    static int findNext(const quint64* words, int from, int to);
+    static int findPrev(const quint64* words, int from, int to);
+};
+
+#endif // EDGEMAP_H
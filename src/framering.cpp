@@ -0,0 +1,149 @@
+#include <atomic>
+#include <cstring>
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "framering.h"
+
+constexpr quint32 FrameRing::kVersion;
+
+struct FrameRing::Data {
+    const uchar* address{nullptr};
+    quint64 size{0};
+
+    ~Data()
+    {
+#ifdef Q_OS_UNIX
+        if (address)
+        {
+            munmap(const_cast<uchar*>(address), size_t(size));
+        }
+#endif
+    }
+
+    const Header* header() const
+    {
+        return reinterpret_cast<const Header*>(address);
+    }
+
+    const Slot* slot(quint64 generation) const
+    {
+        return reinterpret_cast<const Slot*>(address + sizeof(Header)) + generation % header()->slotCount;
+    }
+};
+
+namespace {
+quint64 loadAcquire(const quint64& value)
+{
+    auto result = *static_cast<const volatile quint64*>(&value);
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    return result;
+}
+}
+
+FrameRing::FrameRing()
+{
+}
+
+bool FrameRing::open(const QString& name)
+{
+    close();
+
+#ifdef Q_OS_UNIX
+    auto path = (name.startsWith('/') ? name : '/' + name).toLocal8Bit();
+    auto fd = shm_open(path.constData(), O_RDONLY, 0);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat info;
+    auto isStated = fstat(fd, &info) == 0;
+    auto size = isStated ? quint64(info.st_size) : 0;
+    auto address = size >= sizeof(Header) ? mmap(nullptr, size_t(size), PROT_READ, MAP_SHARED, fd, 0)
+                                          : MAP_FAILED;
+    ::close(fd);
+
+    if (address == MAP_FAILED)
+    {
+        return false;
+    }
+
+    auto data = QSharedPointer<Data>::create();
+    data->address = static_cast<const uchar*>(address);
+    data->size = size;
+
+    auto header = data->header();
+
+    if (std::memcmp(header->magic, "SPMF", sizeof(header->magic)) != 0 ||
+        header->version != kVersion ||
+        header->slotCount == 0 ||
+        sizeof(Header) + quint64(header->slotCount) * sizeof(Slot) > size)
+    {
+        return false;
+    }
+
+    d = data;
+
+    return true;
+#else
+    Q_UNUSED(name)
+    return false;
+#endif
+}
+
+void FrameRing::close()
+{
+    d.reset();
+}
+
+bool FrameRing::isOpen() const
+{
+    return !d.isNull();
+}
+
+quint64 FrameRing::generation() const
+{
+    return d ? loadAcquire(d->header()->generation) : 0;
+}
+
+QImage FrameRing::frame(quint64* generation) const
+{
+    auto latest = FrameRing::generation();
+
+    if (generation)
+    {
+        *generation = latest;
+    }
+
+    if (!latest)
+    {
+        return {};
+    }
+
+    auto slot = d->slot(latest);
+
+    if (loadAcquire(slot->generation) != latest ||
+        slot->width <= 0 || slot->height <= 0 ||
+        slot->bytesPerLine < slot->width * 4 ||
+        slot->offset % 4 ||
+        slot->offset + quint64(slot->bytesPerLine) * quint64(slot->height) > d->size)
+    {
+        return {};
+    }
+
+    return QImage(d->address + slot->offset, slot->width, slot->height, slot->bytesPerLine,
+                  QImage::Format_RGB32, &FrameRing::releaseFrame, new QSharedPointer<Data>(d));
+}
+
+void FrameRing::releaseFrame(void* info)
+{
+    delete static_cast<QSharedPointer<Data>*>(info);
+}
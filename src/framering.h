@@ -0,0 +1,49 @@
+#ifndef FRAMERING_H
+#define FRAMERING_H
+
+#include <QImage>
+#include <QSharedPointer>
+
+class FrameRing
+{
+public:
+    static constexpr quint32 kVersion{1};
+
+    // Shared memory layout: Header, Header::slotCount Slot records, then the pixel data at Slot::offset.
+    // The producer writes the pixels of slot (generation % slotCount), then stores Slot::generation and
+    // after it Header::generation; a slot is not rewritten until slotCount - 1 newer frames are published.
+    struct Header {
+        char magic[4];
+        quint32 version;
+        quint32 slotCount;
+        quint32 reserved;
+        quint64 generation;
+    };
+
+    struct Slot {
+        quint64 generation;
+        qint32 width;
+        qint32 height;
+        qint32 bytesPerLine;
+        quint32 reserved;
+        quint64 offset;
+    };
+
+    FrameRing();
+
+    bool open(const QString& name);
+    void close();
+    bool isOpen() const;
+
+    quint64 generation() const;
+    QImage frame(quint64* generation = nullptr) const;
+
+private:
+    struct Data;
+    QSharedPointer<Data> d;
+
+private:
+    static void releaseFrame(void* info);
+};
+
+#endif // FRAMERING_H
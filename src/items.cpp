@@ -3,9 +3,15 @@
 #include <QGraphicsScene>
 #include <QGraphicsView>
 #include <QGraphicsSceneMouseEvent>
+#include <QStyleOptionGraphicsItem>
+#include <QPainter>
+#include <cstdio>
 
 #include "items.h"
 
+constexpr int GraphicsTextItem::kTextSize;
+constexpr int GraphicsTextItem::kMargin;
+
 GraphicsLineItem::GraphicsLineItem(QGraphicsItem* parent)
     : QGraphicsLineItem(parent)
 {
@@ -185,15 +191,25 @@ QVariant GraphicsFixedVertLineItem::itemChange(QGraphicsItem::GraphicsItemChange
 }
 
 GraphicsTextItem::GraphicsTextItem(QGraphicsItem* parent)
-    : QGraphicsTextItem(parent)
+    : QGraphicsItem(parent)
 {
     setFlag(GraphicsItemFlag::ItemIgnoresTransformations);
+    m_text.reserve(kTextSize);
+
+    QFontMetricsF metrics(m_font);
+    m_textHeight = metrics.height();
+
+    for (int c = 0; c < int(m_advances.size()); ++c)
+    {
+        m_advances[size_t(c)] = metrics.horizontalAdvance(QChar(c));
+    }
 }
 
-void GraphicsTextItem::setText(const QString& value, const QPointF& point,
+void GraphicsTextItem::setText(double value, int precision, const QPointF& point,
                                TextPosCorrection posCorrection)
 {
     m_value = value;
+    m_precision = precision;
     m_point = point;
     m_posCorrection = posCorrection;
     applyText();
@@ -201,42 +217,96 @@ void GraphicsTextItem::setText(const QString& value, const QPointF& point,
 
 void GraphicsTextItem::setData(const QLineF& line)
 {
-    setText(QString::number(line.length() + 1),
+    setText(line.length() + 1, -1,
             {line.center().x(), line.center().y()}, GraphicsTextItem::TextPosCorrection::None);
 }
 
 void GraphicsTextItem::setData(const QRectF& rect, bool isHeightValue)
+{
+    setData(rect, isHeightValue, isHeightValue ? rect.width() + 1 : rect.height() + 1, 0);
+}
+
+void GraphicsTextItem::setData(const QRectF& rect, bool isHeightValue, double value, int precision)
 {
     if (!isHeightValue)
     {
-        setText(QString::number(rect.height() + 1),
-                {rect.right(), rect.center().y()}, GraphicsTextItem::TextPosCorrection::ByY);
+        setText(value, precision, {rect.right(), rect.center().y()}, GraphicsTextItem::TextPosCorrection::ByY);
     }
     else
     {
-        setText(QString::number(rect.width() + 1),
-                {rect.center().x(), rect.top()}, GraphicsTextItem::TextPosCorrection::ByX);
+        setText(value, precision, {rect.center().x(), rect.top()}, GraphicsTextItem::TextPosCorrection::ByX);
     }
 }
 
 void GraphicsTextItem::setPenColor(const QColor& color)
 {
-    setDefaultTextColor(color);
+    m_textColor = color;
+    update();
     applyText();
 }
 
 void GraphicsTextItem::setBgColor(const QColor& color)
 {
     IGraphicsItem::setBgColor(color);
+    update();
     applyText();
 }
 
+QRectF GraphicsTextItem::boundingRect() const
+{
+    return {{0, 0}, m_size};
+}
+
+void GraphicsTextItem::paint(QPainter* painter, const QStyleOptionGraphicsItem*, QWidget*)
+{
+    auto rect = boundingRect().adjusted(kMargin, kMargin, -kMargin, -kMargin);
+
+    painter->fillRect(rect, m_bgColor);
+    painter->setFont(m_font);
+    painter->setPen(m_textColor);
+    painter->drawText(rect, Qt::AlignCenter, m_text);
+}
+
 void GraphicsTextItem::applyText()
 {
-    QString format = QString("<div style='background:%1; color:%2;'>%3</div>");
-    setHtml(format.arg(m_bgColor.name()).arg(defaultTextColor().name()).arg(m_value));
+    char text[kTextSize];
+
+    if (m_precision < 0)
+    {
+        snprintf(text, sizeof(text), "%g", m_value);
+    }
+    else
+    {
+        snprintf(text, sizeof(text), "%.*f", m_precision, m_value);
+    }
+
+    // The label is laid out from cached glyph advances and painted directly, so a new
+    // value only copies into the reserved string instead of building a text document.
+    if (m_text != QLatin1String(text))
+    {
+        qreal width{0};
+
+        for (auto c = text; *c; ++c)
+        {
+            width += m_advances[size_t(uchar(*c) & 0x7f)];
+        }
+
+        m_text.resize(0);
+        m_text.append(QLatin1String(text));
+
+        QSizeF size{width + 2 * kMargin, m_textHeight + 2 * kMargin};
 
-    auto view = scene()->views().empty() ? nullptr : scene()->views()[0];
+        if (size != m_size)
+        {
+            prepareGeometryChange();
+            m_size = size;
+        }
+
+        update();
+    }
+
+    const auto& views = scene()->views();
+    auto view = views.empty() ? nullptr : views.at(0);
     auto th = boundingRect().height() / (view ? view->transform().m22() : 1 );
     auto tw = boundingRect().width() / (view ? view->transform().m11() : 1 );
     double x, y;
@@ -262,6 +332,7 @@ void GraphicsTextItem::applyText()
         if (y < tl.y()) y = tl.y();
         if (y > br.y() - th) y = br.y() - th;
     }
+
     setPos({x, y});
 }
 
@@ -284,16 +355,26 @@ GraphicsMeasureRectItem::GraphicsMeasureRectItem(QGraphicsItem* parent)
 
 void GraphicsMeasureRectItem::setData(const QRectF& rect)
 {
-    QPen p = pen();
-    p.setJoinStyle(rect.width() == 0 || rect.height() == 0
-                   ? Qt::PenJoinStyle::RoundJoin
-                   : Qt::PenJoinStyle::MiterJoin);
-    setPen(p);
+    setData(rect, {rect.width() + 1, rect.height() + 1}, 0);
+}
+
+void GraphicsMeasureRectItem::setData(const QRectF& rect, const QSizeF& size, int precision)
+{
+    auto joinStyle = rect.width() == 0 || rect.height() == 0
+            ? Qt::PenJoinStyle::RoundJoin
+            : Qt::PenJoinStyle::MiterJoin;
+
+    if (pen().joinStyle() != joinStyle)
+    {
+        QPen p = pen();
+        p.setJoinStyle(joinStyle);
+        setPen(p);
+    }
 
     setRect(rect);
 
-    m_labels[0]->setData(rect, true);
-    m_labels[1]->setData(rect, false);
+    m_labels[0]->setData(rect, true, size.width(), precision);
+    m_labels[1]->setData(rect, false, size.height(), precision);
 }
 
 void GraphicsMeasureRectItem::setPenStyle(Qt::PenStyle style)
@@ -337,3 +418,121 @@ QVariant GraphicsMeasureRectItem::itemChange(QGraphicsItem::GraphicsItemChange c
 
     return QGraphicsRectItem::itemChange(change, value);
 }
+
+GraphicsPathItem::GraphicsPathItem(QGraphicsItem* parent)
+    : QGraphicsPathItem(parent)
+{
+    QPen p = pen();
+    p.setCosmetic(true);
+    p.setCapStyle(Qt::PenCapStyle::FlatCap);
+    setPen(p);
+}
+
+void GraphicsPathItem::setData(const QVector<QLineF>& lines)
+{
+    if (lines == m_lines)
+    {
+        return;
+    }
+
+    m_lines = lines;
+    QPainterPath path;
+
+    for (const auto& line : lines)
+    {
+        path.moveTo(line.p1());
+        path.lineTo(line.p2());
+    }
+
+    setPath(path);
+}
+
+void GraphicsPathItem::setPenStyle(Qt::PenStyle style)
+{
+    auto p = pen();
+    p.setStyle(style);
+    setPen(p);
+}
+
+void GraphicsPathItem::setPenColor(const QColor& color)
+{
+    auto p = pen();
+    p.setColor(color);
+    setPen(p);
+}
+
+GraphicsImageItem::GraphicsImageItem(QGraphicsItem* parent)
+    : QGraphicsItem(parent)
+{
+    setFlag(ItemUsesExtendedStyleOption);
+}
+
+void GraphicsImageItem::setImage(const QImage& image)
+{
+    if (m_tiledImage.isNull() && image.cacheKey() == m_image.cacheKey())
+    {
+        return;
+    }
+
+    prepareGeometryChange();
+    m_image = image;
+    m_tiledImage = {};
+    update();
+}
+
+void GraphicsImageItem::setTiledImage(const TiledImage& image)
+{
+    if (image == m_tiledImage)
+    {
+        return;
+    }
+
+    prepareGeometryChange();
+    m_image = {};
+    m_tiledImage = image;
+    update();
+}
+
+QRectF GraphicsImageItem::boundingRect() const
+{
+    return QRectF(m_tiledImage.isNull() ? m_image.rect() : m_tiledImage.rect());
+}
+
+void GraphicsImageItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget*)
+{
+    auto rect = option->exposedRect.toAlignedRect() & boundingRect().toRect();
+
+    if (rect.isEmpty())
+    {
+        return;
+    }
+
+    if (!m_tiledImage.isNull())
+    {
+        paintTiles(painter, rect);
+    }
+    else
+    {
+        painter->drawImage(rect.topLeft(), m_image, rect);
+    }
+}
+
+void GraphicsImageItem::paintTiles(QPainter* painter, const QRect& rect)
+{
+    const auto tileSize = TiledImage::kTileSize;
+    auto size = m_tiledImage.size();
+
+    for (int row = rect.top() / tileSize; row <= rect.bottom() / tileSize; ++row)
+    {
+        for (int column = rect.left() / tileSize; column <= rect.right() / tileSize; ++column)
+        {
+            QRect tileRect{column * tileSize, row * tileSize,
+                           qMin(tileSize, size.width() - column * tileSize),
+                           qMin(tileSize, size.height() - row * tileSize)};
+            auto source = (tileRect & rect).translated(-tileRect.topLeft());
+
+            painter->drawImage(tileRect.topLeft() + source.topLeft(),
+                               m_tiledImage.tile(column, row), source);
+        }
+    }
+}
@@ -3,6 +3,11 @@
 
 #include <QGraphicsItem>
 #include <QColor>
+#include <QFont>
+#include <QImage>
+#include <array>
+
+#include "tiledimage.h"
 
 class IGraphicsItem
 {
@@ -19,8 +24,11 @@ protected:
     bool m_isHovered{false};
 };
 
-class GraphicsTextItem : public IGraphicsItem, public QGraphicsTextItem
+class GraphicsTextItem : public IGraphicsItem, public QGraphicsItem
 {
+    static constexpr int kTextSize{64};
+    static constexpr int kMargin{4};
+
     enum class TextPosCorrection{
         None,
         ByX,
@@ -30,14 +38,24 @@ class GraphicsTextItem : public IGraphicsItem, public QGraphicsTextItem
 public:
     GraphicsTextItem(QGraphicsItem* parent = nullptr);
 
-    void setText(const QString& value, const QPointF& point, TextPosCorrection posCorrection);
+    void setText(double value, int precision, const QPointF& point, TextPosCorrection posCorrection);
     void setData(const QLineF& line);
     void setData(const QRectF& rect, bool isHeightValue);
+    void setData(const QRectF& rect, bool isHeightValue, double value, int precision);
     void setPenColor(const QColor& color) override;
     void setBgColor(const QColor& color) override;
+    QRectF boundingRect() const override;
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) override;
 
 private:
-    QString m_value;
+    double m_value{0};
+    int m_precision{0};
+    QFont m_font;
+    QColor m_textColor;
+    QString m_text;
+    QSizeF m_size;
+    qreal m_textHeight{0};
+    std::array<qreal, 128> m_advances{};
     QPointF m_point;
     TextPosCorrection m_posCorrection;
 
@@ -121,6 +139,7 @@ public:
     GraphicsMeasureRectItem(QGraphicsItem* parent = nullptr);
 
     void setData(const QRectF& rect);
+    void setData(const QRectF& rect, const QSizeF& size, int precision);
     void setPenStyle(Qt::PenStyle style) override;
     void setPenColor(const QColor& color) override;
     void setBgColor(const QColor& color) override;
@@ -132,4 +151,35 @@ protected:
     QVariant itemChange(GraphicsItemChange change, const QVariant& value) override;
 };
 
+class GraphicsPathItem : public IGraphicsItem, public QGraphicsPathItem
+{
+public:
+    GraphicsPathItem(QGraphicsItem* parent = nullptr);
+
+    void setData(const QVector<QLineF>& lines);
+    void setPenStyle(Qt::PenStyle style) override;
+    void setPenColor(const QColor& color) override;
+
+private:
+    QVector<QLineF> m_lines;
+};
+
+class GraphicsImageItem : public QGraphicsItem
+{
+public:
+    GraphicsImageItem(QGraphicsItem* parent = nullptr);
+
+    void setImage(const QImage& image);
+    void setTiledImage(const TiledImage& image);
+    QRectF boundingRect() const override;
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) override;
+
+private:
+    QImage m_image;
+    TiledImage m_tiledImage;
+
+private:
+    void paintTiles(QPainter* painter, const QRect& rect);
+};
+
 #endif // ITEMS_H
@@ -1,14 +1,149 @@
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <QDebug>
 
 #include "window.h"
+#include "measurementserver.h"
+#include "recorder.h"
+#include "replayer.h"
+#include "sequencetracker.h"
+#include "profiler.h"
+#include "screencapturer.h"
 
 int main(int argc, char *argv[])
 {
+    Profiler::markStartup();
+
+    for (int i = 1; i < argc; ++i)
+    {
+        auto isHeadless = QByteArray(argv[i]) == "--replay" || QByteArray(argv[i]) == "--track";
+
+        if (isHeadless && !qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        }
+    }
+
+    ScreenCapturer::initializeThreads();
     QApplication a(argc, argv);
 
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addOptions({
+        {"session", "Open the session <file> instead of capturing the screen.", "file"},
+        {"record", "Record the input events into <file> on exit.", "file"},
+        {"replay", "Replay the recorded input events from <file> and report latencies.", "file"},
+        {"max-p50", "Fail the replay if the median event latency exceeds <ms>.", "ms"},
+        {"max-p99", "Fail the replay if the 99th percentile event latency exceeds <ms>.", "ms"},
+        {"startup-report", "Print the time to the first frame and to the first measurement and quit."},
+        {"serve", "Serve measurement queries on the local socket <name>.", "name"},
+        {"ingest", "Measure the frames published into the shared memory ring <name>.", "name"},
+        {"track", "Track an element through the frames of <source> (PNG folder, .y4m or raw RGB file).", "source"},
+        {"at", "Pick the tracked element at <x,y> of the first frame.", "x,y"},
+        {"pinned", "Measure the distances to the pinned rectangle <x,y,width,height>.", "x,y,width,height"},
+        {"frame-size", "Frame size <width>x<height> of a raw RGB stream.", "size"},
+        {"csv", "Write the tracked rectangles to <file> instead of the standard output.", "file"}
+    });
+    parser.process(a);
+
+    if (parser.isSet("track"))
+    {
+        auto at = parser.value("at").split(',');
+        auto pinned = parser.value("pinned").split(',');
+        auto frameSize = parser.value("frame-size").split('x');
+        auto isPinned = pinned.size() == 4;
+        QRect pinnedRect;
+
+        if (isPinned)
+        {
+            pinnedRect = {pinned[0].toInt(), pinned[1].toInt(), pinned[2].toInt() - 1, pinned[3].toInt() - 1};
+        }
+
+        SequenceTracker tracker;
+        QFile csv(parser.value("csv"));
+
+        if (at.size() != 2)
+        {
+            QTextStream(stderr) << "Pick the tracked element with --at x,y\n";
+            return Replayer::kLoadFailed;
+        }
+
+        if (!(parser.isSet("csv") ? csv.open(QIODevice::WriteOnly | QIODevice::Truncate)
+                                  : csv.open(stdout, QIODevice::WriteOnly)))
+        {
+            QTextStream(stderr) << "Cannot write " << parser.value("csv") << "\n";
+            return Replayer::kLoadFailed;
+        }
+
+        if (!tracker.open(parser.value("track"), frameSize.size() == 2
+                          ? QSize(frameSize[0].toInt(), frameSize[1].toInt()) : QSize()))
+        {
+            QTextStream(stderr) << "Cannot track " << parser.value("track") << ": " << tracker.errorString() << "\n";
+            return Replayer::kLoadFailed;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+
+        auto count = tracker.track({at[0].toInt(), at[1].toInt()}, pinnedRect, isPinned, &csv);
+
+        QTextStream(stderr) << QString("Tracked %1 frames in %2 ms\n").arg(count).arg(timer.elapsed());
+        return 0;
+    }
+
     Window w;
     w.resize(1024, 800);
-    w.show();
+    w.setStartupReportEnabled(parser.isSet("startup-report"));
+
+    if (parser.isSet("session") && !w.openSession(parser.value("session")))
+    {
+        QTextStream(stderr) << "Cannot open session " << parser.value("session") << "\n";
+        return Replayer::kLoadFailed;
+    }
+
+    if (parser.isSet("ingest") && !w.openFrameRing(parser.value("ingest")))
+    {
+        QTextStream(stderr) << "Cannot open frame ring " << parser.value("ingest") << "\n";
+        return Replayer::kLoadFailed;
+    }
+
+    if (parser.isSet("replay"))
+    {
+        Replayer replayer(&w);
+
+        if (!replayer.load(parser.value("replay")))
+        {
+            QTextStream(stderr) << "Cannot load recording " << parser.value("replay") << "\n";
+            return Replayer::kLoadFailed;
+        }
 
+        return replayer.run(parser.value("max-p50").toDouble(), parser.value("max-p99").toDouble());
+    }
+
+    if (parser.isSet("serve"))
+    {
+        auto server = new MeasurementServer(w.view(), &w);
+
+        if (!server->listen(parser.value("serve")))
+        {
+            QTextStream(stderr) << "Cannot listen on " << parser.value("serve") << "\n";
+            return Replayer::kLoadFailed;
+        }
+
+        qInfo().noquote() << "Serving measurements on" << server->fullServerName();
+    }
+
+    if (parser.isSet("record"))
+    {
+        auto recorder = new Recorder(&w);
+        QObject::connect(&a, &QApplication::aboutToQuit, [&](){
+            recorder->save(parser.value("record"));
+        });
+    }
+
+    w.show();
     return a.exec();
 }
@@ -0,0 +1,345 @@
+#include <QFutureWatcher>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QtConcurrent>
+#include <cstring>
+
+#include "measurementserver.h"
+#include "calculator.h"
+#include "view.h"
+
+constexpr char MeasurementServer::kRequestMagic[5];
+constexpr char MeasurementServer::kReplyMagic[5];
+const int MeasurementServer::kMaxBatchSize;
+const int MeasurementServer::kParallelBatchSize;
+
+namespace {
+const QHash<QString, quint32> kOperations{
+    {"rect", MeasurementServer::Rectangle},
+    {"distance", MeasurementServer::Distance},
+    {"color", MeasurementServer::Color}
+};
+}
+
+MeasurementServer::MeasurementServer(View* view, QObject* parent) :
+    QObject(parent),
+    m_server(new QLocalServer(this)),
+    m_view(view)
+{
+    connect(m_server, &QLocalServer::newConnection, this, &MeasurementServer::onNewConnection);
+}
+
+bool MeasurementServer::listen(const QString& name)
+{
+    QLocalServer::removeServer(name);
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+
+    return m_server->listen(name);
+}
+
+QString MeasurementServer::fullServerName() const
+{
+    return m_server->fullServerName();
+}
+
+void MeasurementServer::onNewConnection()
+{
+    while (auto socket = m_server->nextPendingConnection())
+    {
+        m_buffers.insert(socket, {});
+
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket](){
+            onReadyRead(socket);
+        });
+        connect(socket, &QLocalSocket::disconnected, this, [this, socket](){
+            m_buffers.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void MeasurementServer::onReadyRead(QLocalSocket* socket)
+{
+    auto& buffer = m_buffers[socket];
+    buffer += socket->readAll();
+
+    Batch batch;
+    bool isInvalid{false};
+
+    while (takeBatch(buffer, batch, isInvalid))
+    {
+        dispatch(socket, batch);
+        batch = {};
+    }
+
+    if (isInvalid)
+    {
+        socket->disconnectFromServer();
+    }
+}
+
+bool MeasurementServer::takeBatch(QByteArray& buffer, Batch& batch, bool& isInvalid)
+{
+    if (buffer.isEmpty())
+    {
+        return false;
+    }
+
+    if (buffer.startsWith('{'))
+    {
+        auto end = buffer.indexOf('\n');
+
+        if (end < 0)
+        {
+            return false;
+        }
+
+        auto line = buffer.left(end);
+        buffer.remove(0, end + 1);
+        batch.isJson = true;
+
+        if (!parseJson(line, batch))
+        {
+            batch.queries.clear();
+            batch.imagePath.clear();
+            batch.id = 0;
+        }
+
+        return true;
+    }
+
+    if (buffer.size() < int(sizeof(Header)))
+    {
+        return false;
+    }
+
+    Header header;
+    std::memcpy(&header, buffer.constData(), sizeof(Header));
+
+    if (std::memcmp(header.magic, kRequestMagic, sizeof(header.magic)) != 0 ||
+        header.count > quint32(kMaxBatchSize) || header.pathLength > 4096)
+    {
+        isInvalid = true;
+        return false;
+    }
+
+    auto size = int(sizeof(Header) + header.pathLength + header.count * sizeof(Query));
+
+    if (buffer.size() < size)
+    {
+        return false;
+    }
+
+    batch.id = header.id;
+    batch.imagePath = QString::fromUtf8(buffer.constData() + sizeof(Header), int(header.pathLength));
+    batch.queries.resize(int(header.count));
+    std::memcpy(batch.queries.data(), buffer.constData() + sizeof(Header) + header.pathLength,
+                header.count * sizeof(Query));
+    buffer.remove(0, size);
+
+    return true;
+}
+
+void MeasurementServer::dispatch(QLocalSocket* socket, const Batch& batch)
+{
+    auto isLive = batch.imagePath.isEmpty();
+    const auto& renderData = m_view->renderData();
+    auto image = isLive ? renderData.screenImage
+                        : batch.imagePath == m_imagePath ? m_image : QImage{};
+    auto edgeMap = isLive ? m_view->edgeMap() : EdgeMap{};
+    auto watcher = new QFutureWatcher<Reply>(socket);
+
+    connect(watcher, &QFutureWatcher<Reply>::finished, this, [this, socket, watcher](){
+        auto reply = watcher->result();
+
+        if (!reply.image.isNull())
+        {
+            m_imagePath = reply.imagePath;
+            m_image = reply.image;
+        }
+
+        socket->write(reply.data);
+        watcher->deleteLater();
+    });
+
+    watcher->setFuture(QtConcurrent::run(&MeasurementServer::process, batch, image, edgeMap));
+}
+
+MeasurementServer::Reply MeasurementServer::process(const Batch& batch, QImage image, const EdgeMap& edgeMap)
+{
+    Reply reply;
+
+    if (image.isNull() && !batch.imagePath.isEmpty())
+    {
+        image = Calculator::toPixelViewImage(QImage(batch.imagePath));
+        reply.imagePath = batch.imagePath;
+        reply.image = image;
+    }
+
+    if (image.isNull())
+    {
+        reply.data = batch.isJson ? toJson(batch.id, {}, "no image") : toBinary(batch.id, {});
+        return reply;
+    }
+
+    const auto& src = image;
+    const auto& edges = edgeMap.size() == src.size() ? edgeMap : EdgeMap{};
+    QVector<Result> results;
+
+    if (batch.queries.size() < kParallelBatchSize)
+    {
+        results.reserve(batch.queries.size());
+
+        for (const auto& query : batch.queries)
+        {
+            results.push_back(measure(query, src, edges));
+        }
+    }
+    else
+    {
+        results = QtConcurrent::blockingMapped<QVector<Result>>(batch.queries, [&](const Query& query){
+            return measure(query, src, edges);
+        });
+    }
+
+    reply.data = batch.isJson ? toJson(batch.id, results, {}) : toBinary(batch.id, results);
+
+    return reply;
+}
+
+MeasurementServer::Result MeasurementServer::measure(const Query& query, const QImage& img, const EdgeMap& edgeMap)
+{
+    Result result{query.operation, {0, 0, 0, 0}};
+
+    auto rectAt = [&](int x, int y){
+        return edgeMap.isNull() ? Calculator::calculateCursorRectangle({x, y}, img)
+                                : Calculator::calculateCursorRectangle({x, y}, edgeMap);
+    };
+
+    switch (query.operation)
+    {
+    case Rectangle:
+    {
+        QPoint pos{query.args[0], query.args[1]};
+
+        if (img.rect().contains(pos))
+        {
+            auto rect = rectAt(pos.x(), pos.y());
+            result.values[0] = rect.x();
+            result.values[1] = rect.y();
+            result.values[2] = rect.width() + 1;
+            result.values[3] = rect.height() + 1;
+        }
+        break;
+    }
+    case Distance:
+    {
+        QPoint first{query.args[0], query.args[1]};
+        QPoint second{query.args[2], query.args[3]};
+
+        if (img.rect().contains(first) && img.rect().contains(second))
+        {
+            auto lines = Calculator::calculateMeasureLines(rectAt(first.x(), first.y()),
+                                                           rectAt(second.x(), second.y()));
+            result.values[0] = lines[1].dx() > 0 ? lines[1].dx() + 1 : 0;
+            result.values[1] = lines[0].dy() > 0 ? lines[0].dy() + 1 : 0;
+        }
+        break;
+    }
+    case Color:
+        if (img.rect().contains(query.args[0], query.args[1]))
+        {
+            result.values[0] = qint32(img.pixel(query.args[0], query.args[1]) & RGB_MASK);
+        }
+        break;
+    default:
+        result.operation = 0;
+    }
+
+    return result;
+}
+
+bool MeasurementServer::parseJson(const QByteArray& line, Batch& batch)
+{
+    auto root = QJsonDocument::fromJson(line).object();
+    auto queries = root["queries"].toArray();
+
+    batch.id = quint32(root["id"].toInt());
+    batch.imagePath = root["image"].toString();
+
+    if (queries.size() > kMaxBatchSize)
+    {
+        return false;
+    }
+
+    batch.queries.reserve(queries.size());
+
+    for (const auto& value : queries)
+    {
+        auto object = value.toObject();
+        auto operation = kOperations.value(object["op"].toString());
+        const auto point = object["at"].toArray();
+        const auto to = object["to"].toArray();
+        auto hasTo = to.size() >= 2;
+
+        if (point.size() < 2 || (operation == Distance && !hasTo))
+        {
+            return false;
+        }
+
+        batch.queries.push_back({operation, {point.at(0).toInt(), point.at(1).toInt(),
+                                             hasTo ? to.at(0).toInt() : 0, hasTo ? to.at(1).toInt() : 0}});
+    }
+
+    return true;
+}
+
+QByteArray MeasurementServer::toJson(quint32 id, const QVector<Result>& results, const QString& error)
+{
+    QJsonArray array;
+
+    for (const auto& result : results)
+    {
+        switch (result.operation)
+        {
+        case Rectangle:
+            array.append(QJsonObject{{"rect", QJsonArray{result.values[0], result.values[1],
+                                                         result.values[2], result.values[3]}}});
+            break;
+        case Distance:
+            array.append(QJsonObject{{"horizontal", result.values[0]}, {"vertical", result.values[1]}});
+            break;
+        case Color:
+            array.append(QJsonObject{{"color", QColor(QRgb(result.values[0])).name()}});
+            break;
+        default:
+            array.append(QJsonObject{{"error", "unknown op"}});
+        }
+    }
+
+    QJsonObject root{{"id", qint64(id)}, {"results", array}};
+
+    if (!error.isEmpty())
+    {
+        root["error"] = error;
+    }
+
+    return QJsonDocument(root).toJson(QJsonDocument::Compact) + '\n';
+}
+
+QByteArray MeasurementServer::toBinary(quint32 id, const QVector<Result>& results)
+{
+    Header header;
+    std::memcpy(header.magic, kReplyMagic, sizeof(header.magic));
+    header.id = id;
+    header.count = quint32(results.size());
+    header.pathLength = 0;
+
+    QByteArray data(reinterpret_cast<const char*>(&header), sizeof(Header));
+    data.append(reinterpret_cast<const char*>(results.constData()), int(results.size() * sizeof(Result)));
+
+    return data;
+}
@@ -0,0 +1,86 @@
+#ifndef MEASUREMENTSERVER_H
+#define MEASUREMENTSERVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QImage>
+#include <QVector>
+
+#include "edgemap.h"
+
+class QLocalServer;
+class QLocalSocket;
+class View;
+
+class MeasurementServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr char kRequestMagic[5]{"SPMQ"};
+    static constexpr char kReplyMagic[5]{"SPMR"};
+    static const int kMaxBatchSize{65536};
+    static const int kParallelBatchSize{256};
+
+    enum Operation : quint32 {
+        Rectangle = 1,
+        Distance = 2,
+        Color = 3
+    };
+
+    struct Header {
+        char magic[4];
+        quint32 id;
+        quint32 count;
+        quint32 pathLength;
+    };
+
+    struct Query {
+        quint32 operation;
+        qint32 args[4];
+    };
+
+    struct Result {
+        quint32 operation;
+        qint32 values[4];
+    };
+
+    explicit MeasurementServer(View* view, QObject* parent = nullptr);
+
+    bool listen(const QString& name);
+    QString fullServerName() const;
+
+private:
+    struct Batch {
+        quint32 id{0};
+        bool isJson{false};
+        QString imagePath;
+        QVector<Query> queries;
+    };
+
+    struct Reply {
+        QByteArray data;
+        QString imagePath;
+        QImage image;
+    };
+
+    QLocalServer* m_server;
+    View* m_view;
+    QHash<QLocalSocket*, QByteArray> m_buffers;
+    QString m_imagePath;
+    QImage m_image;
+
+private:
+    void onNewConnection();
+    void onReadyRead(QLocalSocket* socket);
+    bool takeBatch(QByteArray& buffer, Batch& batch, bool& isInvalid);
+    void dispatch(QLocalSocket* socket, const Batch& batch);
+
+    static Reply process(const Batch& batch, QImage image, const EdgeMap& edgeMap);
+    static Result measure(const Query& query, const QImage& img, const EdgeMap& edgeMap);
+    static bool parseJson(const QByteArray& line, Batch& batch);
+    static QByteArray toJson(quint32 id, const QVector<Result>& results, const QString& error);
+    static QByteArray toBinary(quint32 id, const QVector<Result>& results);
+};
+
+#endif // MEASUREMENTSERVER_H
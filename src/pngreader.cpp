@@ -0,0 +1,350 @@
+#include <QtEndian>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#ifdef SPM_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "pngreader.h"
+
+const int PngReader::kInputSize;
+
+struct PngReader::Stream {
+#ifdef SPM_HAVE_ZLIB
+    z_stream z{};
+    bool isInitialized{false};
+
+    ~Stream()
+    {
+        if (isInitialized)
+        {
+            inflateEnd(&z);
+        }
+    }
+#endif
+};
+
+PngReader::PngReader()
+    : m_stream(new Stream)
+{
+}
+
+PngReader::~PngReader()
+{
+}
+
+bool PngReader::open(const QString& fileName)
+{
+    m_file.setFileName(fileName);
+
+    if (!m_file.open(QIODevice::ReadOnly))
+    {
+        return fail(m_file.errorString());
+    }
+
+#ifdef SPM_HAVE_ZLIB
+    return readHeader();
+#else
+    return fail("Reading PNG images by rows requires zlib");
+#endif
+}
+
+QSize PngReader::size() const
+{
+    return m_size;
+}
+
+bool PngReader::read(QImage& band)
+{
+    if (band.format() != QImage::Format_RGB32 || band.width() != m_size.width() ||
+        m_nextRow + band.height() > m_size.height())
+    {
+        return fail("Invalid PNG band");
+    }
+
+    for (int y = 0; y < band.height(); ++y)
+    {
+        if (!inflateRow())
+        {
+            return false;
+        }
+
+        unfilter();
+        convert(reinterpret_cast<QRgb*>(band.scanLine(y)));
+        std::swap(m_row, m_previous);
+        ++m_nextRow;
+    }
+
+    return true;
+}
+
+QString PngReader::errorString() const
+{
+    return m_error;
+}
+
+bool PngReader::readHeader()
+{
+#ifdef SPM_HAVE_ZLIB
+    const char signature[] = "\x89PNG\r\n\x1a\n";
+
+    if (m_file.read(8) != QByteArray(signature, 8))
+    {
+        return fail("Not a PNG image");
+    }
+
+    quint32 length{0};
+    QByteArray type;
+    auto interlace = 0;
+
+    while (readChunkHeader(length, type))
+    {
+        if (type == "IHDR" && length == 13)
+        {
+            auto header = m_file.read(13);
+
+            if (header.size() != 13)
+            {
+                return fail("Truncated PNG header");
+            }
+
+            auto bytes = reinterpret_cast<const uchar*>(header.constData());
+            m_size = QSize(int(qFromBigEndian<quint32>(bytes)), int(qFromBigEndian<quint32>(bytes + 4)));
+            m_bitDepth = bytes[8];
+            m_colorType = bytes[9];
+            interlace = bytes[12];
+            m_file.seek(m_file.pos() + 4);
+        }
+        else if (type == "PLTE")
+        {
+            auto palette = m_file.read(length);
+
+            for (int i = 0; i + 2 < palette.size(); i += 3)
+            {
+                m_palette.push_back(qRgb(uchar(palette[i]), uchar(palette[i + 1]), uchar(palette[i + 2])));
+            }
+
+            m_file.seek(m_file.pos() + 4);
+        }
+        else if (type == "IDAT")
+        {
+            m_chunkLeft = length;
+            break;
+        }
+        else if (type == "IEND")
+        {
+            return fail("PNG image without data");
+        }
+        else
+        {
+            m_file.seek(m_file.pos() + length + 4);
+        }
+    }
+
+    if (type != "IDAT")
+    {
+        return fail("Truncated PNG image");
+    }
+
+    switch (m_colorType)
+    {
+    case 0: m_channels = 1; break;
+    case 2: m_channels = 3; break;
+    case 3: m_channels = 1; break;
+    case 4: m_channels = 2; break;
+    case 6: m_channels = 4; break;
+    default: m_channels = 0; break;
+    }
+
+    auto isBitDepthValid = m_bitDepth == 8 || m_bitDepth == 16 ||
+            ((m_colorType == 0 || m_colorType == 3) && (m_bitDepth == 1 || m_bitDepth == 2 || m_bitDepth == 4));
+
+    if (m_size.width() <= 0 || m_size.height() <= 0 || !m_channels || !isBitDepthValid ||
+        (m_colorType == 3 && (m_palette.isEmpty() || m_bitDepth == 16)))
+    {
+        return fail("Unsupported PNG image format");
+    }
+
+    if (interlace)
+    {
+        return fail("Interlaced PNG images cannot be read by rows");
+    }
+
+    auto rowBytes = (qint64(m_size.width()) * m_channels * m_bitDepth + 7) / 8;
+
+    if (rowBytes >= std::numeric_limits<int>::max())
+    {
+        return fail("PNG image is too wide");
+    }
+
+    m_pixelBytes = qMax(1, m_channels * m_bitDepth / 8);
+    m_rowBytes = int(rowBytes);
+    m_row.assign(size_t(m_rowBytes) + 1, 0);
+    m_previous.assign(size_t(m_rowBytes) + 1, 0);
+    m_input.resize(size_t(kInputSize));
+
+    if (inflateInit(&m_stream->z) != Z_OK)
+    {
+        return fail("Cannot initialize zlib");
+    }
+
+    m_stream->isInitialized = true;
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool PngReader::readChunkHeader(quint32& length, QByteArray& type)
+{
+    auto header = m_file.read(8);
+
+    if (header.size() != 8)
+    {
+        return false;
+    }
+
+    length = qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(header.constData()));
+    type = header.mid(4);
+
+    return true;
+}
+
+bool PngReader::inflateRow()
+{
+#ifdef SPM_HAVE_ZLIB
+    auto& z = m_stream->z;
+    z.next_out = m_row.data();
+    z.avail_out = uInt(m_row.size());
+
+    while (z.avail_out > 0)
+    {
+        if (z.avail_in == 0)
+        {
+            quint32 length{0};
+            QByteArray type;
+
+            while (m_chunkLeft == 0)
+            {
+                m_file.seek(m_file.pos() + 4);
+
+                if (!readChunkHeader(length, type) || type != "IDAT")
+                {
+                    return fail("Truncated PNG image data");
+                }
+
+                m_chunkLeft = length;
+            }
+
+            auto count = m_file.read(reinterpret_cast<char*>(m_input.data()),
+                                     qMin<qint64>(m_chunkLeft, qint64(m_input.size())));
+
+            if (count <= 0)
+            {
+                return fail("Truncated PNG image data");
+            }
+
+            m_chunkLeft -= quint32(count);
+            z.next_in = m_input.data();
+            z.avail_in = uInt(count);
+        }
+
+        auto result = inflate(&z, Z_NO_FLUSH);
+
+        if ((result == Z_STREAM_END && z.avail_out > 0) || (result != Z_OK && result != Z_STREAM_END))
+        {
+            return fail("Corrupt PNG image data");
+        }
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool PngReader::fail(const QString& error)
+{
+    m_error = error;
+    return false;
+}
+
+void PngReader::unfilter()
+{
+    auto row = m_row.data() + 1;
+    auto previous = m_previous.data() + 1;
+    auto bpp = m_pixelBytes;
+
+    for (int i = 0; i < m_rowBytes; ++i)
+    {
+        int a = i >= bpp ? row[i - bpp] : 0;
+        int b = previous[i];
+        int c = i >= bpp ? previous[i - bpp] : 0;
+
+        switch (m_row[0])
+        {
+        case 1:
+            row[i] = uchar(row[i] + a);
+            break;
+        case 2:
+            row[i] = uchar(row[i] + b);
+            break;
+        case 3:
+            row[i] = uchar(row[i] + (a + b) / 2);
+            break;
+        case 4:
+        {
+            auto p = a + b - c;
+            auto pa = std::abs(p - a);
+            auto pb = std::abs(p - b);
+            auto pc = std::abs(p - c);
+            row[i] = uchar(row[i] + (pa <= pb && pa <= pc ? a : pb <= pc ? b : c));
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+void PngReader::convert(QRgb* out) const
+{
+    const auto maxValue = (1 << qMin(m_bitDepth, 8)) - 1;
+
+    for (int x = 0; x < m_size.width(); ++x)
+    {
+        switch (m_colorType)
+        {
+        case 0:
+        case 4:
+        {
+            auto gray = sample(x * m_channels) * 255 / maxValue;
+            out[x] = qRgb(gray, gray, gray);
+            break;
+        }
+        case 3:
+            out[x] = m_palette.value(sample(x), qRgb(0, 0, 0));
+            break;
+        default:
+            out[x] = qRgb(sample(x * m_channels), sample(x * m_channels + 1), sample(x * m_channels + 2));
+            break;
+        }
+    }
+}
+
+int PngReader::sample(int index) const
+{
+    auto row = m_row.data() + 1;
+
+    if (m_bitDepth >= 8)
+    {
+        return row[index * (m_bitDepth / 8)];
+    }
+
+    auto bit = index * m_bitDepth;
+
+    return (row[bit / 8] >> (8 - m_bitDepth - bit % 8)) & ((1 << m_bitDepth) - 1);
+}
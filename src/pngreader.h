@@ -0,0 +1,51 @@
+#ifndef PNGREADER_H
+#define PNGREADER_H
+
+#include <QFile>
+#include <QImage>
+#include <QScopedPointer>
+#include <vector>
+
+class PngReader
+{
+public:
+    static const int kInputSize{64 * 1024};
+
+    PngReader();
+    ~PngReader();
+
+    bool open(const QString& fileName);
+    QSize size() const;
+    bool read(QImage& band);
+    QString errorString() const;
+
+private:
+    struct Stream;
+
+    QFile m_file;
+    QScopedPointer<Stream> m_stream;
+    QSize m_size;
+    int m_bitDepth{0};
+    int m_colorType{0};
+    int m_channels{0};
+    int m_pixelBytes{0};
+    int m_rowBytes{0};
+    int m_nextRow{0};
+    quint32 m_chunkLeft{0};
+    QVector<QRgb> m_palette;
+    std::vector<uchar> m_input;
+    std::vector<uchar> m_row;
+    std::vector<uchar> m_previous;
+    QString m_error;
+
+private:
+    bool readHeader();
+    bool readChunkHeader(quint32& length, QByteArray& type);
+    bool inflateRow();
+    bool fail(const QString& error);
+    void unfilter();
+    void convert(QRgb* out) const;
+    int sample(int index) const;
+};
+
+#endif // PNGREADER_H
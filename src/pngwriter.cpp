@@ -0,0 +1,201 @@
+#include <QFile>
+#include <QtConcurrent>
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#ifdef SPM_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "pngwriter.h"
+
+const int PngWriter::kBandHeight;
+const int PngWriter::kCompressionLevel;
+
+#ifdef SPM_HAVE_ZLIB
+namespace {
+void appendBigEndian(QByteArray& data, quint32 value)
+{
+    data.append(char(value >> 24));
+    data.append(char(value >> 16));
+    data.append(char(value >> 8));
+    data.append(char(value));
+}
+}
+#endif
+
+bool PngWriter::write(const QImage& img, const QString& fileName)
+{
+#ifdef SPM_HAVE_ZLIB
+    auto data = encode(img);
+    QFile file(fileName);
+
+    return !data.isEmpty() &&
+            file.open(QIODevice::WriteOnly | QIODevice::Truncate) &&
+            file.write(data) == data.size();
+#else
+    return img.save(fileName, "PNG");
+#endif
+}
+
+#ifdef SPM_HAVE_ZLIB
+QByteArray PngWriter::encode(const QImage& img)
+{
+    if (img.isNull())
+    {
+        return {};
+    }
+
+    struct Band {
+        QByteArray compressed;
+        uLong adler{0};
+        uLong length{0};
+        bool isValid{false};
+    };
+
+    const auto& src = img.format() == QImage::Format_RGB32 ? img : img.convertToFormat(QImage::Format_RGB32);
+    const auto width = src.width();
+    const auto height = src.height();
+    const auto bandHeight = kBandHeight;
+    const auto rowBytes = 1 + width * 3;
+
+    QVector<Band> bands((height + bandHeight - 1) / bandHeight);
+    QVector<int> indices(bands.size());
+    std::iota(indices.begin(), indices.end(), 0);
+
+    auto bandData = bands.data();
+    auto isLast = [&](int index){ return index + 1 == indices.size(); };
+
+    QtConcurrent::blockingMap(indices, [&](int index){
+        auto& band = bandData[index];
+        auto top = index * bandHeight;
+        auto bottom = qMin(top + bandHeight, height);
+        QByteArray raw(rowBytes * (bottom - top), Qt::Uninitialized);
+        std::vector<uchar> line(size_t(width) * 3);
+        std::vector<uchar> previous(size_t(width) * 3);
+
+        auto toRgb = [&](int y, std::vector<uchar>& out){
+            auto pixels = reinterpret_cast<const QRgb*>(src.constScanLine(y));
+
+            for (int x = 0; x < width; ++x)
+            {
+                out[size_t(x) * 3] = uchar(qRed(pixels[x]));
+                out[size_t(x) * 3 + 1] = uchar(qGreen(pixels[x]));
+                out[size_t(x) * 3 + 2] = uchar(qBlue(pixels[x]));
+            }
+        };
+
+        if (top > 0)
+        {
+            toRgb(top - 1, previous);
+        }
+
+        for (int y = top; y < bottom; ++y)
+        {
+            toRgb(y, line);
+            filterLine(line.data(), y > 0 ? previous.data() : nullptr, width * 3,
+                       reinterpret_cast<uchar*>(raw.data()) + (y - top) * rowBytes);
+            line.swap(previous);
+        }
+
+        z_stream stream{};
+
+        if (deflateInit2(&stream, kCompressionLevel, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            return;
+        }
+
+        band.compressed.resize(int(deflateBound(&stream, uLong(raw.size()))) + 16);
+        stream.next_in = reinterpret_cast<Bytef*>(raw.data());
+        stream.avail_in = uInt(raw.size());
+        stream.next_out = reinterpret_cast<Bytef*>(band.compressed.data());
+        stream.avail_out = uInt(band.compressed.size());
+
+        auto result = deflate(&stream, isLast(index) ? Z_FINISH : Z_SYNC_FLUSH);
+
+        band.compressed.resize(int(stream.total_out));
+        band.adler = adler32(adler32(0L, Z_NULL, 0), reinterpret_cast<const Bytef*>(raw.constData()), uInt(raw.size()));
+        band.length = uLong(raw.size());
+        band.isValid = isLast(index) ? result == Z_STREAM_END : result == Z_OK && stream.avail_in == 0;
+
+        deflateEnd(&stream);
+    });
+
+    QByteArray header;
+    appendBigEndian(header, quint32(width));
+    appendBigEndian(header, quint32(height));
+    header.append(char(8));
+    header.append(char(2));
+    header.append(char(0));
+    header.append(char(0));
+    header.append(char(0));
+
+    QByteArray idat;
+    idat.append(char(0x78));
+    idat.append(char(0x9c));
+
+    auto adler = adler32(0L, Z_NULL, 0);
+
+    for (const auto& band : bands)
+    {
+        if (!band.isValid)
+        {
+            return {};
+        }
+
+        idat.append(band.compressed);
+        adler = adler32_combine(adler, band.adler, z_off_t(band.length));
+    }
+
+    appendBigEndian(idat, quint32(adler));
+
+    QByteArray png("\x89PNG\r\n\x1a\n", 8);
+    png.append(chunk("IHDR", header));
+    png.append(chunk("IDAT", idat));
+    png.append(chunk("IEND", {}));
+
+    return png;
+}
+
+void PngWriter::filterLine(const uchar* line, const uchar* previous, int length, uchar* out)
+{
+    const int bpp{3};
+    int costs[3]{0, 0, 0};
+
+    for (int i = 0; i < length; ++i)
+    {
+        auto left = i >= bpp ? line[i - bpp] : 0;
+        auto up = previous ? previous[i] : 0;
+
+        costs[0] += qAbs(int(qint8(line[i])));
+        costs[1] += qAbs(int(qint8(uchar(line[i] - left))));
+        costs[2] += qAbs(int(qint8(uchar(line[i] - up))));
+    }
+
+    auto filter = int(std::min_element(costs, costs + 3) - costs);
+    out[0] = uchar(filter);
+
+    for (int i = 0; i < length; ++i)
+    {
+        auto left = i >= bpp ? line[i - bpp] : 0;
+        auto up = previous ? previous[i] : 0;
+
+        out[i + 1] = uchar(line[i] - (filter == 1 ? left : filter == 2 ? up : 0));
+    }
+}
+
+QByteArray PngWriter::chunk(const char* type, const QByteArray& data)
+{
+    QByteArray result;
+    appendBigEndian(result, quint32(data.size()));
+    result.append(type, 4);
+    result.append(data);
+
+    auto crc = crc32(0L, Z_NULL, 0);
+    crc = crc32(crc, reinterpret_cast<const Bytef*>(result.constData() + 4), uInt(data.size() + 4));
+    appendBigEndian(result, quint32(crc));
+
+    return result;
+}
+#endif
@@ -0,0 +1,20 @@
+#ifndef PNGWRITER_H
+#define PNGWRITER_H
+
+#include <QImage>
+
+class PngWriter
+{
+public:
+    static const int kBandHeight{64};
+    static const int kCompressionLevel{6};
+
+    static bool write(const QImage& img, const QString& fileName);
+
+private:
+    static QByteArray encode(const QImage& img);
+    static void filterLine(const uchar* line, const uchar* previous, int length, uchar* out);
+    static QByteArray chunk(const char* type, const QByteArray& data);
+};
+
+#endif // PNGWRITER_H
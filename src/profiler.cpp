@@ -0,0 +1,78 @@
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+#include "profiler.h"
+
+namespace {
+QAtomicInteger<qint64> bufferAllocations{0};
+QAtomicInteger<qint64> bufferBytes{0};
+QElapsedTimer startupTimer;
+thread_local qint64 heapAllocations{0};
+}
+
+qint64 Profiler::peakResidentBytes()
+{
+#ifdef Q_OS_UNIX
+    rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+#ifdef Q_OS_MACOS
+        return usage.ru_maxrss;
+#else
+        return qint64(usage.ru_maxrss) * 1024;
+#endif
+    }
+#endif
+
+    return 0;
+}
+
+void Profiler::countBufferAllocation(qint64 bytes)
+{
+    bufferAllocations.fetchAndAddRelaxed(1);
+    bufferBytes.fetchAndAddRelaxed(bytes);
+}
+
+qint64 Profiler::bufferAllocationCount()
+{
+    return bufferAllocations.loadRelaxed();
+}
+
+qint64 Profiler::bufferAllocatedBytes()
+{
+    return bufferBytes.loadRelaxed();
+}
+
+void Profiler::markStartup()
+{
+    startupTimer.start();
+}
+
+qint64 Profiler::sinceStartup()
+{
+    return startupTimer.isValid() ? startupTimer.elapsed() : -1;
+}
+
+bool Profiler::isHeapAllocationCounted()
+{
+#ifdef SPM_COUNT_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Profiler::countHeapAllocation()
+{
+    ++heapAllocations;
+}
+
+qint64 Profiler::heapAllocationCount()
+{
+    return heapAllocations;
+}
@@ -0,0 +1,20 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <QtGlobal>
+
+class Profiler
+{
+public:
+    static qint64 peakResidentBytes();
+    static void countBufferAllocation(qint64 bytes);
+    static qint64 bufferAllocationCount();
+    static qint64 bufferAllocatedBytes();
+    static void markStartup();
+    static qint64 sinceStartup();
+    static bool isHeapAllocationCounted();
+    static void countHeapAllocation();
+    static qint64 heapAllocationCount();
+};
+
+#endif // PROFILER_H
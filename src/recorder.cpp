@@ -0,0 +1,91 @@
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMouseEvent>
+#include <QShortcut>
+#include <QWheelEvent>
+
+#include "recorder.h"
+#include "window.h"
+#include "view.h"
+
+const int Recorder::kVersion;
+
+Recorder::Recorder(Window* window) :
+    QObject(window),
+    m_window(window)
+{
+    window->view()->viewport()->installEventFilter(this);
+
+    for (auto shortcut : window->findChildren<QShortcut*>())
+    {
+        shortcut->installEventFilter(this);
+    }
+
+    m_timer.start();
+}
+
+bool Recorder::save(const QString& fileName) const
+{
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        return false;
+    }
+
+    QJsonObject root{
+        {"version", kVersion},
+        {"windowSize", QJsonArray{m_window->width(), m_window->height()}},
+        {"events", m_events}
+    };
+
+    return file.write(QJsonDocument(root).toJson(QJsonDocument::Compact)) > 0;
+}
+
+bool Recorder::eventFilter(QObject* watched, QEvent* event)
+{
+    QJsonObject record{{"t", m_timer.nsecsElapsed() / 1000}};
+
+    switch (event->type())
+    {
+    case QEvent::MouseMove:
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonRelease:
+    {
+        auto mouseEvent = static_cast<QMouseEvent*>(event);
+        record["type"] = event->type() == QEvent::MouseMove ? "move"
+                       : event->type() == QEvent::MouseButtonPress ? "press" : "release";
+        record["x"] = mouseEvent->x();
+        record["y"] = mouseEvent->y();
+        record["button"] = int(mouseEvent->button());
+        record["buttons"] = int(mouseEvent->buttons());
+        record["modifiers"] = int(mouseEvent->modifiers());
+        break;
+    }
+    case QEvent::Wheel:
+    {
+        auto wheelEvent = static_cast<QWheelEvent*>(event);
+        record["type"] = "wheel";
+        record["x"] = wheelEvent->position().x();
+        record["y"] = wheelEvent->position().y();
+        record["dx"] = wheelEvent->angleDelta().x();
+        record["dy"] = wheelEvent->angleDelta().y();
+        record["pixelX"] = wheelEvent->pixelDelta().x();
+        record["pixelY"] = wheelEvent->pixelDelta().y();
+        record["buttons"] = int(wheelEvent->buttons());
+        record["modifiers"] = int(wheelEvent->modifiers());
+        break;
+    }
+    case QEvent::Shortcut:
+        record["type"] = "shortcut";
+        record["key"] = static_cast<QShortcut*>(watched)->key().toString();
+        break;
+    default:
+        return false;
+    }
+
+    m_events.append(record);
+
+    return false;
+}
@@ -0,0 +1,30 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QJsonArray>
+
+class Window;
+
+class Recorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int kVersion{1};
+
+    explicit Recorder(Window* window);
+
+    bool save(const QString& fileName) const;
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
+private:
+    Window* m_window;
+    QElapsedTimer m_timer;
+    QJsonArray m_events;
+};
+
+#endif // RECORDER_H
@@ -0,0 +1,291 @@
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFontMetrics>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <QTextStream>
+
+#include "redline.h"
+#include "pngwriter.h"
+
+const int Redline::kFontPixelSize;
+
+bool Redline::save(const QString& fileName, const RenderData& renderData, const Palette& palette)
+{
+    const auto& img = renderData.screenImage;
+
+    if (img.isNull())
+    {
+        return false;
+    }
+
+    QFileInfo info(fileName);
+    auto baseName = info.dir().filePath(info.completeBaseName());
+    auto marks = collectMarks(renderData, palette);
+    auto svgData = toSvg(img.size(), marks, palette);
+    auto jsonData = toJson(renderData, img.size(), marks);
+
+    QFile svg(baseName + ".svg");
+    QFile json(baseName + ".json");
+
+    return PngWriter::write(burn(img, marks, palette), baseName + ".png") &&
+            svg.open(QIODevice::WriteOnly | QIODevice::Truncate) &&
+            svg.write(svgData) == svgData.size() &&
+            json.open(QIODevice::WriteOnly | QIODevice::Truncate) &&
+            json.write(jsonData) == jsonData.size();
+}
+
+std::vector<Redline::Mark> Redline::collectMarks(const RenderData& renderData, const Palette& palette)
+{
+    std::vector<Mark> marks;
+
+    auto addRect = [&](const QString& name, const QRect& rect, const QColor& color, bool isDashed){
+        Mark mark;
+        mark.name = name;
+        mark.rect = rect;
+        mark.color = color;
+        mark.isRect = true;
+        mark.isDashed = isDashed;
+        mark.isLabeled = true;
+        marks.push_back(mark);
+    };
+
+    auto addLine = [&](const QString& name, const QLine& line, const QColor& color,
+                       bool isDashed, bool isLabeled){
+        Mark mark;
+        mark.name = name;
+        mark.line = line;
+        mark.color = color;
+        mark.isDashed = isDashed;
+        mark.isLabeled = isLabeled;
+        marks.push_back(mark);
+    };
+
+    if (renderData.isFixedRectPresent)
+    {
+        for (const auto& line : renderData.fixedLines)
+        {
+            addLine("fixedLine", line, palette.fixedLines, false, false);
+        }
+
+        addRect("fixedRectangle", renderData.fixedRectangle, palette.fixedRectangle, false);
+    }
+
+    if (renderData.isCursorRectPresent)
+    {
+        if (renderData.cursorHLine.dx() > 0)
+        {
+            addLine("cursorHLine", renderData.cursorHLine, palette.cursorLines, false, false);
+        }
+
+        if (renderData.cursorVLine.dy() > 0)
+        {
+            addLine("cursorVLine", renderData.cursorVLine, palette.cursorLines, false, false);
+        }
+
+        addRect("cursorRectangle", renderData.cursorRectangle, palette.cursorRectangle, false);
+
+        if (renderData.isReferencePresent && !renderData.referenceRectangle.isNull())
+        {
+            addRect("referenceRectangle", renderData.referenceRectangle, palette.difference, true);
+        }
+
+        if (renderData.isClearancePresent && !renderData.clearanceLine.isNull())
+        {
+            addLine("clearance", renderData.clearanceLine, palette.measureLines, true, true);
+        }
+    }
+
+    if (renderData.isFixedRectPresent && renderData.measureHLine.dx() > 0)
+    {
+        addLine("horizontalDistance", renderData.measureHLine, palette.measureLines, false, true);
+    }
+
+    if (renderData.isFixedRectPresent && renderData.measureVLine.dy() > 0)
+    {
+        addLine("verticalDistance", renderData.measureVLine, palette.measureLines, false, true);
+    }
+
+    return marks;
+}
+
+std::vector<Redline::Label> Redline::labels(const Mark& mark)
+{
+    if (!mark.isLabeled)
+    {
+        return {};
+    }
+
+    if (!mark.isRect)
+    {
+        auto center = QLineF(mark.line).center().toPoint();
+
+        return {{QString::number(QLineF(mark.line).length() + 1), center, Qt::AlignCenter}};
+    }
+
+    const auto& rect = mark.rect;
+
+    return {
+        {QString::number(rect.width() + 1), {rect.x() + rect.width() / 2, rect.y()},
+         Qt::AlignHCenter | Qt::AlignBottom},
+        {QString::number(rect.height() + 1), {rect.x() + rect.width() + 1, rect.y() + rect.height() / 2},
+         Qt::AlignLeft | Qt::AlignVCenter}
+    };
+}
+
+QImage Redline::burn(const QImage& img, const std::vector<Mark>& marks, const Palette& palette)
+{
+    auto result = img.convertToFormat(QImage::Format_RGB32);
+    QPainter painter(&result);
+    auto font = painter.font();
+    font.setPixelSize(kFontPixelSize);
+    painter.setFont(font);
+
+    QFontMetrics metrics(font);
+
+    for (const auto& mark : marks)
+    {
+        painter.setPen(QPen(mark.color, 0, mark.isDashed ? Qt::DashLine : Qt::SolidLine));
+
+        if (mark.isRect)
+        {
+            painter.drawRect(mark.rect);
+        }
+        else
+        {
+            painter.drawLine(mark.line);
+        }
+    }
+
+    for (const auto& mark : marks)
+    {
+        for (const auto& label : labels(mark))
+        {
+            auto box = metrics.boundingRect(label.text).adjusted(-2, -1, 2, 1);
+            auto x = label.anchor.x() - (label.alignment & Qt::AlignHCenter ? box.width() / 2 : 0);
+            auto y = label.anchor.y() - (label.alignment & Qt::AlignBottom ? box.height()
+                                         : label.alignment & Qt::AlignVCenter ? box.height() / 2 : 0);
+
+            box.moveTo(qBound(0, x, qMax(0, result.width() - box.width())),
+                       qBound(0, y, qMax(0, result.height() - box.height())));
+
+            painter.fillRect(box, palette.background);
+            painter.setPen(mark.color);
+            painter.drawText(box, Qt::AlignCenter, label.text);
+        }
+    }
+
+    return result;
+}
+
+QByteArray Redline::toSvg(const QSize& size, const std::vector<Mark>& marks, const Palette& palette)
+{
+    QString svg;
+    QTextStream stream(&svg);
+
+    stream << QString("<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%1\" height=\"%2\" "
+                      "viewBox=\"0 0 %1 %2\" font-family=\"sans-serif\" font-size=\"%3\">\n")
+              .arg(size.width()).arg(size.height()).arg(kFontPixelSize);
+
+    for (const auto& mark : marks)
+    {
+        auto stroke = QString("fill=\"none\" stroke=\"%1\" stroke-width=\"1\"%2")
+                .arg(mark.color.name(), mark.isDashed ? " stroke-dasharray=\"4 2\"" : "");
+
+        if (mark.isRect)
+        {
+            stream << QString("  <rect id=\"%1\" x=\"%2\" y=\"%3\" width=\"%4\" height=\"%5\" %6/>\n")
+                      .arg(mark.name)
+                      .arg(mark.rect.x() + 0.5).arg(mark.rect.y() + 0.5)
+                      .arg(mark.rect.width()).arg(mark.rect.height())
+                      .arg(stroke);
+        }
+        else
+        {
+            stream << QString("  <line id=\"%1\" x1=\"%2\" y1=\"%3\" x2=\"%4\" y2=\"%5\" %6/>\n")
+                      .arg(mark.name)
+                      .arg(mark.line.x1() + 0.5).arg(mark.line.y1() + 0.5)
+                      .arg(mark.line.x2() + 0.5).arg(mark.line.y2() + 0.5)
+                      .arg(stroke);
+        }
+    }
+
+    for (const auto& mark : marks)
+    {
+        for (const auto& label : labels(mark))
+        {
+            stream << QString("  <text x=\"%1\" y=\"%2\" fill=\"%3\" stroke=\"%4\" stroke-width=\"3\" "
+                              "paint-order=\"stroke\" text-anchor=\"%5\" dominant-baseline=\"%6\">%7</text>\n")
+                      .arg(label.anchor.x()).arg(label.anchor.y())
+                      .arg(mark.color.name(), palette.background.name(),
+                           label.alignment & Qt::AlignHCenter ? "middle" : "start",
+                           label.alignment & Qt::AlignBottom ? "text-after-edge" : "central",
+                           label.text);
+        }
+    }
+
+    stream << "</svg>\n";
+    stream.flush();
+
+    return svg.toUtf8();
+}
+
+QByteArray Redline::toJson(const RenderData& renderData, const QSize& size, const std::vector<Mark>& marks)
+{
+    QJsonObject root;
+    root["width"] = size.width();
+    root["height"] = size.height();
+    root["cursorPoint"] = QJsonArray{renderData.cursorPoint.x(), renderData.cursorPoint.y()};
+
+    if (renderData.cursorColor.isValid())
+    {
+        root["cursorColor"] = renderData.cursorColor.name();
+    }
+
+    QJsonArray items;
+
+    for (const auto& mark : marks)
+    {
+        QJsonObject item;
+        item["name"] = mark.name;
+        item["color"] = mark.color.name();
+
+        if (mark.isRect)
+        {
+            item["type"] = "rect";
+            item["x"] = mark.rect.x();
+            item["y"] = mark.rect.y();
+            item["width"] = mark.rect.width() + 1;
+            item["height"] = mark.rect.height() + 1;
+        }
+        else
+        {
+            item["type"] = "line";
+            item["x1"] = mark.line.x1();
+            item["y1"] = mark.line.y1();
+            item["x2"] = mark.line.x2();
+            item["y2"] = mark.line.y2();
+            item["length"] = QLineF(mark.line).length() + 1;
+        }
+
+        items.append(item);
+    }
+
+    root["marks"] = items;
+
+    if (!renderData.colorStats.isNull())
+    {
+        const auto& stats = renderData.colorStats;
+        QJsonObject colorStats;
+        colorStats["average"] = stats.average().name();
+        colorStats["minimum"] = stats.minimum().name();
+        colorStats["maximum"] = stats.maximum().name();
+        colorStats["uniqueCount"] = stats.uniqueCount();
+        root["colorStats"] = colorStats;
+    }
+
+    return QJsonDocument(root).toJson();
+}
@@ -0,0 +1,40 @@
+#ifndef REDLINE_H
+#define REDLINE_H
+
+#include <QImage>
+#include <vector>
+
+#include "data.h"
+
+class Redline
+{
+public:
+    static const int kFontPixelSize{11};
+
+    static bool save(const QString& fileName, const RenderData& renderData, const Palette& palette);
+
+private:
+    struct Mark {
+        QString name;
+        QRect rect;
+        QLine line;
+        QColor color;
+        bool isRect{false};
+        bool isDashed{false};
+        bool isLabeled{false};
+    };
+
+    struct Label {
+        QString text;
+        QPoint anchor;
+        Qt::Alignment alignment;
+    };
+
+    static std::vector<Mark> collectMarks(const RenderData& renderData, const Palette& palette);
+    static std::vector<Label> labels(const Mark& mark);
+    static QImage burn(const QImage& img, const std::vector<Mark>& marks, const Palette& palette);
+    static QByteArray toSvg(const QSize& size, const std::vector<Mark>& marks, const Palette& palette);
+    static QByteArray toJson(const RenderData& renderData, const QSize& size, const std::vector<Mark>& marks);
+};
+
+#endif // REDLINE_H
@@ -0,0 +1,255 @@
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMouseEvent>
+#include <QShortcut>
+#include <QTextStream>
+#include <QWheelEvent>
+#include <algorithm>
+#include <cmath>
+
+#include "replayer.h"
+#include "recorder.h"
+#include "window.h"
+#include "view.h"
+#include "profiler.h"
+
+const int Replayer::kLoadFailed;
+const int Replayer::kThresholdExceeded;
+const int Replayer::kAllocationWarmupEvents;
+
+namespace {
+const QStringList kSkippedKeys{QKeySequence(QKeySequence::Save).toString(),
+                               QKeySequence(QKeySequence::Open).toString(),
+                               QKeySequence(Qt::CTRL + Qt::Key_R).toString(),
+                               QKeySequence(Qt::CTRL + Qt::Key_E).toString(),
+                               QKeySequence(Qt::Key_Escape).toString()};
+}
+
+Replayer::Replayer(Window* window) :
+    QObject(window),
+    m_window(window)
+{
+    window->view()->viewport()->installEventFilter(this);
+}
+
+bool Replayer::load(const QString& fileName)
+{
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    auto root = QJsonDocument::fromJson(file.readAll()).object();
+    auto windowSize = root["windowSize"].toArray();
+
+    if (root["version"].toInt() != Recorder::kVersion || windowSize.size() != 2)
+    {
+        return false;
+    }
+
+    m_windowSize = {windowSize[0].toInt(), windowSize[1].toInt()};
+    m_events = root["events"].toArray();
+
+    return true;
+}
+
+int Replayer::run(double maxMedianMs, double maxP99Ms)
+{
+    m_window->resize(m_windowSize);
+    m_window->show();
+    QApplication::processEvents();
+
+    m_frameCount = 0;
+    m_moveUpdates = 0;
+    m_allocatingMoves = 0;
+    m_moveAllocations = 0;
+    m_sceneAllocations = 0;
+    QMap<QString, std::vector<double>> latencies;
+    QElapsedTimer clock;
+    clock.start();
+
+    for (const auto& value : m_events)
+    {
+        auto record = value.toObject();
+        auto remaining = record["t"].toVariant().toLongLong() / 1000 - clock.elapsed();
+
+        while (remaining > 0)
+        {
+            QApplication::processEvents(QEventLoop::AllEvents, int(remaining));
+            remaining = record["t"].toVariant().toLongLong() / 1000 - clock.elapsed();
+        }
+
+        auto updateCount = m_window->view()->updateCount();
+        QElapsedTimer timer;
+        timer.start();
+
+        if (!replay(record))
+        {
+            continue;
+        }
+
+        QApplication::processEvents();
+        latencies[record["type"].toString()].push_back(timer.nsecsElapsed() / 1e6);
+
+        if (record["type"].toString() == "move")
+        {
+            countMoveAllocations(updateCount);
+        }
+    }
+
+    std::vector<double> all;
+    QTextStream out(stdout);
+    out << QString("%1 %2 %3 %4 %5 %6\n")
+           .arg("event", -10).arg("count", 8).arg("p50 ms", 10).arg("p90 ms", 10).arg("p99 ms", 10).arg("max ms", 10);
+
+    for (auto it = latencies.begin(); it != latencies.end(); ++it)
+    {
+        all.insert(all.end(), it.value().begin(), it.value().end());
+        out << report(it.key(), it.value());
+    }
+
+    out << report("all", all);
+    out << QString("frames %1 in %2 ms\n").arg(m_frameCount).arg(clock.elapsed());
+
+    for (const auto& stage : m_window->view()->stageCounters())
+    {
+        out << QString("stage %1: %2 hits, %3 misses\n").arg(stage.name).arg(stage.hits).arg(stage.misses);
+    }
+
+    if (Profiler::isHeapAllocationCounted())
+    {
+        out << QString("move allocations %1 in %2 updates, %3 allocating after warm-up\n")
+               .arg(m_moveAllocations).arg(m_moveUpdates).arg(m_allocatingMoves);
+        out << QString("scene and title allocations %1 in %2 updates (not gated)\n")
+               .arg(m_sceneAllocations).arg(m_moveUpdates);
+    }
+
+    if (m_allocatingMoves > 0)
+    {
+        out << QString("FAILED: %1 mouse-move measurements allocated on the heap\n").arg(m_allocatingMoves);
+        return kThresholdExceeded;
+    }
+
+    if (all.empty())
+    {
+        return 0;
+    }
+
+    auto median = percentile(all, 0.5);
+    auto p99 = percentile(all, 0.99);
+
+    if ((maxMedianMs > 0 && median > maxMedianMs) || (maxP99Ms > 0 && p99 > maxP99Ms))
+    {
+        out << QString("FAILED: p50 %1 ms (limit %2), p99 %3 ms (limit %4)\n")
+               .arg(median, 0, 'f', 3).arg(maxMedianMs).arg(p99, 0, 'f', 3).arg(maxP99Ms);
+        return kThresholdExceeded;
+    }
+
+    return 0;
+}
+
+bool Replayer::eventFilter(QObject*, QEvent* event)
+{
+    if (event->type() == QEvent::Paint)
+    {
+        ++m_frameCount;
+    }
+
+    return false;
+}
+
+bool Replayer::replay(const QJsonObject& record)
+{
+    auto viewport = m_window->view()->viewport();
+    auto type = record["type"].toString();
+    QPointF pos{record["x"].toDouble(), record["y"].toDouble()};
+    auto buttons = Qt::MouseButtons(record["buttons"].toInt());
+    auto modifiers = Qt::KeyboardModifiers(record["modifiers"].toInt());
+
+    if (type == "move" || type == "press" || type == "release")
+    {
+        auto eventType = type == "move" ? QEvent::MouseMove
+                       : type == "press" ? QEvent::MouseButtonPress : QEvent::MouseButtonRelease;
+        QMouseEvent event(eventType, pos, viewport->mapToGlobal(pos.toPoint()),
+                          Qt::MouseButton(record["button"].toInt()), buttons, modifiers);
+        QApplication::sendEvent(viewport, &event);
+        return true;
+    }
+
+    if (type == "wheel")
+    {
+        QWheelEvent event(pos, viewport->mapToGlobal(pos.toPoint()),
+                          {record["pixelX"].toInt(), record["pixelY"].toInt()},
+                          {record["dx"].toInt(), record["dy"].toInt()},
+                          buttons, modifiers, Qt::NoScrollPhase, false);
+        QApplication::sendEvent(viewport, &event);
+        return true;
+    }
+
+    auto key = record["key"].toString();
+
+    if (type != "shortcut" || kSkippedKeys.contains(key))
+    {
+        return false;
+    }
+
+    for (auto shortcut : m_window->findChildren<QShortcut*>())
+    {
+        if (shortcut->key().toString() == key)
+        {
+            emit shortcut->activated();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Replayer::countMoveAllocations(qint64 previousUpdateCount)
+{
+    auto view = m_window->view();
+
+    if (view->updateCount() == previousUpdateCount)
+    {
+        return;
+    }
+
+    auto allocations = view->calculationAllocationCount();
+
+    m_moveAllocations += allocations;
+    m_sceneAllocations += view->sceneAllocationCount();
+
+    if (++m_moveUpdates > kAllocationWarmupEvents && allocations > 0)
+    {
+        ++m_allocatingMoves;
+    }
+}
+
+double Replayer::percentile(const std::vector<double>& sorted, double fraction)
+{
+    auto index = size_t(std::ceil(fraction * sorted.size()));
+
+    return sorted[qBound(size_t(1), index, sorted.size()) - 1];
+}
+
+QString Replayer::report(const QString& name, std::vector<double>& latencies)
+{
+    if (latencies.empty())
+    {
+        return {};
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+
+    return QString("%1 %2 %3 %4 %5 %6\n")
+            .arg(name, -10).arg(latencies.size(), 8)
+            .arg(percentile(latencies, 0.5), 10, 'f', 3)
+            .arg(percentile(latencies, 0.9), 10, 'f', 3)
+            .arg(percentile(latencies, 0.99), 10, 'f', 3)
+            .arg(latencies.back(), 10, 'f', 3);
+}
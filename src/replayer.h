@@ -0,0 +1,46 @@
+#ifndef REPLAYER_H
+#define REPLAYER_H
+
+#include <QObject>
+#include <QJsonArray>
+#include <QMap>
+#include <QSize>
+#include <vector>
+
+class Window;
+
+class Replayer : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int kLoadFailed{2};
+    static const int kThresholdExceeded{1};
+    static const int kAllocationWarmupEvents{8};
+
+    explicit Replayer(Window* window);
+
+    bool load(const QString& fileName);
+    int run(double maxMedianMs, double maxP99Ms);
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
+private:
+    Window* m_window;
+    QSize m_windowSize;
+    QJsonArray m_events;
+    int m_frameCount{0};
+    int m_moveUpdates{0};
+    int m_allocatingMoves{0};
+    qint64 m_moveAllocations{0};
+    qint64 m_sceneAllocations{0};
+
+private:
+    bool replay(const QJsonObject& record);
+    void countMoveAllocations(qint64 previousUpdateCount);
+    static double percentile(const std::vector<double>& sorted, double fraction);
+    static QString report(const QString& name, std::vector<double>& latencies);
+};
+
+#endif // REPLAYER_H
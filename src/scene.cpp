@@ -1,53 +1,129 @@
 #include <QGraphicsRectItem>
 #include <QGraphicsLineItem>
-#include <QGraphicsPixmapItem>
 
 #include "scene.h"
 
 Scene::Scene(QObject* parent)
     : QGraphicsScene(parent)
 {
-    initialize();
 }
 
 void Scene::setRenderData(const RenderData& renderData)
 {
-    if (renderData.screenImage.isNull())
+    if (renderData.screenImage.isNull() && renderData.tiledImage.isNull())
         return;
 
+    if (!m_screenImageItem)
+    {
+        initialize();
+    }
+
     setVisibility(renderData);
 
-    m_screenImageItem->setPixmap(renderData.screenImage);
+    if (renderData.tiledImage.isNull())
+    {
+        m_screenImageItem->setImage(renderData.screenImage);
+    }
+    else
+    {
+        m_screenImageItem->setTiledImage(renderData.tiledImage);
+    }
+
+    m_diffImageItem->setImage(renderData.diffImage);
+    m_clearanceImageItem->setImage(renderData.clearanceImage);
 
     m_cursorHLineItem->setData(toFloat(renderData.cursorHLine));
     m_cursorVLineItem->setData(toFloat(renderData.cursorVLine));
-    m_cursorRectangleItem->setData(toFloat(renderData.cursorRectangle));
+
+    if (renderData.isSubpixelPresent)
+    {
+        m_cursorRectangleItem->setData(toFloat(renderData.cursorRectangle),
+                                       renderData.subpixelRectangle.size(), kSubpixelPrecision);
+    }
+    else
+    {
+        m_cursorRectangleItem->setData(toFloat(renderData.cursorRectangle));
+    }
 
     m_fixedRectangleItem->setData(toFloat(renderData.fixedRectangle));
+    m_referenceRectangleItem->setData(toFloat(renderData.referenceRectangle));
+    m_containerRectangleItem->setData(toFloat(renderData.containerRectangle));
     m_measureHLineItem->setData(toFloat(renderData.measureHLine));
     m_measureVLineItem->setData(toFloat(renderData.measureVLine));
+    m_clearanceLineItem->setData(toFloat(renderData.clearanceLine));
+    m_baselineItem->setData(toFloat(renderData.baselineLine));
 
     int i{0};
     for (auto fixedLineItem : m_fixedLinesItem)
     {
-        fixedLineItem->setLine(toFloat(renderData.fixedLines[i++]));
+        fixedLineItem->setData(toFloat(renderData.fixedLines[i++]));
+    }
+
+    i = 0;
+    for (auto insetLineItem : m_insetLinesItem)
+    {
+        insetLineItem->setData(toFloat(renderData.insetLines[i++]));
+    }
+
+    if (renderData.alignmentLines != m_alignmentLines)
+    {
+        applyAlignmentLines(renderData.alignmentLines);
     }
 
     m_currentFixedRectangle = renderData.fixedRectangle;
 
-    setSceneRect(itemsBoundingRect());
+    if (sceneRect() != m_screenImageItem->boundingRect())
+    {
+        setSceneRect(m_screenImageItem->boundingRect());
+    }
+}
+
+void Scene::applyAlignmentLines(const QVector<QLine>& lines)
+{
+    QVector<QLineF> alignmentLines;
+    alignmentLines.reserve(lines.size());
+
+    for (const auto& line : lines)
+    {
+        alignmentLines.push_back(toFloat(line));
+    }
+
+    m_alignmentItem->setData(alignmentLines);
+    m_alignmentLines = QVector<QLine>(lines.constBegin(), lines.constEnd());
 }
 
 void Scene::setPalette(const Palette& palette)
 {
+    m_palette = palette;
+
+    if (m_screenImageItem)
+    {
+        applyPalette();
+    }
+}
+
+void Scene::applyPalette()
+{
+    const auto& palette = m_palette;
+
     m_cursorHLineItem->setPenColor(palette.cursorLines);
     m_cursorVLineItem->setPenColor(palette.cursorLines);
 
     m_measureHLineItem->setPenColor(palette.measureLines);
     m_measureVLineItem->setPenColor(palette.measureLines);
+    m_clearanceLineItem->setPenColor(palette.measureLines);
+    m_baselineItem->setPenColor(palette.cursorLines);
 
     m_cursorRectangleItem->setPenColor(palette.cursorRectangle);
     m_fixedRectangleItem->setPenColor(palette.fixedRectangle);
+    m_referenceRectangleItem->setPenColor(palette.difference);
+    m_containerRectangleItem->setPenColor(palette.cursorLines);
+    m_alignmentItem->setPenColor(palette.fixedLines);
+
+    for (auto insetLineItem : m_insetLinesItem)
+    {
+        insetLineItem->setPenColor(palette.measureLines);
+    }
 
     for (auto fixedLineItem : m_fixedLinesItem)
     {
@@ -85,14 +161,19 @@ bool Scene::isDragableItemSelected(const QPoint& pos) const
 
 bool Scene::isDragableItemHovered(const QPoint &pos) const
 {
+    if (!m_screenImageItem)
+    {
+        return false;
+    }
+
     QPointF fpos {pos.x() + 0.5, pos.y() + 0.5};
 
-    for (auto item : items(fpos))
+    for (auto item : m_fixedLinesItem)
     {
-        if (auto it = dynamic_cast<IGraphicsItem*>(item))
+        if (item->isVisible() && item->isHovered() &&
+            item->boundingRect().contains(item->mapFromScene(fpos)))
         {
-            if (it->isHovered())
-                return true;
+            return true;
         }
     }
 
@@ -101,10 +182,17 @@ bool Scene::isDragableItemHovered(const QPoint &pos) const
 
 void Scene::initialize()
 {
-    m_screenImageItem = addPixmap({});
+    setItemIndexMethod(NoIndex);
+
+    m_screenImageItem = addGraphicsItem<GraphicsImageItem>();
+    m_screenImageItem->setCacheMode(QGraphicsItem::DeviceCoordinateCache);
+    m_diffImageItem = addGraphicsItem<GraphicsImageItem>();
+    m_clearanceImageItem = addGraphicsItem<GraphicsImageItem>();
 
     m_cursorHLineItem = addGraphicsItem<GraphicsLineItem>();
     m_cursorVLineItem = addGraphicsItem<GraphicsLineItem>();
+    m_baselineItem = addGraphicsItem<GraphicsLineItem>();
+    m_baselineItem->setPenStyle(Qt::PenStyle::DashLine);
 
     int i{0};
     for (auto& fixedLineItem : m_fixedLinesItem)
@@ -133,14 +221,29 @@ void Scene::initialize()
 
     m_cursorRectangleItem = addGraphicsItem<GraphicsMeasureRectItem>();
     m_fixedRectangleItem  = addGraphicsItem<GraphicsMeasureRectItem>();
+    m_referenceRectangleItem = addGraphicsItem<GraphicsMeasureRectItem>();
+    m_referenceRectangleItem->setPenStyle(Qt::PenStyle::DashLine);
+    m_alignmentItem = addGraphicsItem<GraphicsPathItem>();
+    m_containerRectangleItem = addGraphicsItem<GraphicsMeasureRectItem>();
+    m_containerRectangleItem->setPenStyle(Qt::PenStyle::DashDotLine);
     m_measureHLineItem = addGraphicsItem<GraphicsMeasureLineItem>();
     m_measureVLineItem = addGraphicsItem<GraphicsMeasureLineItem>();
 
     m_measureHLineItem->setPenStyle(Qt::PenStyle::DotLine);
     m_measureVLineItem->setPenStyle(Qt::PenStyle::DotLine);
 
+    m_clearanceLineItem = addGraphicsItem<GraphicsMeasureLineItem>();
+    m_clearanceLineItem->setPenStyle(Qt::PenStyle::DashDotLine);
+
+    for (auto& insetLineItem : m_insetLinesItem)
+    {
+        insetLineItem = addGraphicsItem<GraphicsMeasureLineItem>();
+        insetLineItem->setPenStyle(Qt::PenStyle::DotLine);
+    }
+
     hideAll();
     setOpacity(0.75);
+    applyPalette();
 
     setSceneRect(itemsBoundingRect());
 }
@@ -195,6 +298,36 @@ void Scene::setVisibility(const RenderData& renderData)
 
     m_fixedRectangleItem->setVisible(renderData.isFixedRectPresent);
 
+    m_diffImageItem->setVisible(!renderData.diffImage.isNull());
+
+    m_clearanceImageItem->setVisible(renderData.isClearancePresent &&
+                                     !renderData.clearanceImage.isNull());
+    m_clearanceLineItem->setVisible(m_cursorRectangleItem->isVisible() &&
+                                    renderData.isClearancePresent &&
+                                    !renderData.clearanceLine.isNull());
+
+    m_alignmentItem->setVisible(renderData.isFixedRectPresent &&
+                                renderData.isAlignmentPresent &&
+                                !renderData.alignmentLines.isEmpty());
+
+    m_baselineItem->setVisible(m_cursorRectangleItem->isVisible() &&
+                               renderData.isTextPresent);
+
+    m_referenceRectangleItem->setVisible(m_cursorRectangleItem->isVisible() &&
+                                         renderData.isReferencePresent &&
+                                         !renderData.referenceRectangle.isNull());
+
+    m_containerRectangleItem->setVisible(m_cursorRectangleItem->isVisible() &&
+                                         renderData.isContainerPresent);
+
+    int i{0};
+    for (auto insetLineItem : m_insetLinesItem)
+    {
+        const auto& line = renderData.insetLines[i++];
+        insetLineItem->setVisible(m_containerRectangleItem->isVisible() &&
+                                  line.dx() >= 0 && line.dy() >= 0);
+    }
+
     for (auto fixedLineItem : m_fixedLinesItem)
     {
         fixedLineItem->setVisible(renderData.isFixedRectPresent);
@@ -206,14 +339,14 @@ void Scene::onFixedLinesChanged(int index, const QPointF& point)
     int x = point.x();
     int y = point.y();
 
-    std::vector<std::array<int, 4>> margins{
-        {0, y, 0, 0},
-        {0, 0, 0, y},
-        {x, 0, 0, 0},
-        {0, 0, x, 0}
-    };
+    const std::array<std::array<int, 4>, 4> margins{{
+        {{0, y, 0, 0}},
+        {{0, 0, 0, y}},
+        {{x, 0, 0, 0}},
+        {{0, 0, x, 0}}
+    }};
 
-    auto margin = margins[index];
+    const auto& margin = margins[size_t(index)];
     auto rect = m_originalFixedRectangle.adjusted(
                 margin[0],
                 margin[1],
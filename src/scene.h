@@ -10,6 +10,8 @@ class Scene : public QGraphicsScene
 {
     Q_OBJECT
 
+    const int kSubpixelPrecision{1};
+
 public:
     Scene(QObject* parent = nullptr);
 
@@ -23,24 +25,36 @@ signals:
     void fixedRectanglChanged(const QRect& rect);
 
 private:
-    QGraphicsPixmapItem* m_screenImageItem;
+    GraphicsImageItem* m_screenImageItem{nullptr};
+    GraphicsImageItem* m_diffImageItem;
+    GraphicsImageItem* m_clearanceImageItem;
     GraphicsLineItem* m_cursorHLineItem;
     GraphicsLineItem* m_cursorVLineItem;
     GraphicsLineItem* m_measureHLineItem;
     GraphicsLineItem* m_measureVLineItem;
+    GraphicsLineItem* m_clearanceLineItem;
+    GraphicsLineItem* m_baselineItem;
     GraphicsMeasureRectItem* m_cursorRectangleItem;
     GraphicsMeasureRectItem* m_fixedRectangleItem;
+    GraphicsMeasureRectItem* m_referenceRectangleItem;
+    GraphicsMeasureRectItem* m_containerRectangleItem;
     std::array<GraphicsLineItem*, 4> m_fixedLinesItem;
+    std::array<GraphicsLineItem*, 4> m_insetLinesItem;
+    GraphicsPathItem* m_alignmentItem;
 
+    Palette m_palette;
     QRect m_originalFixedRectangle;
     QRect m_currentFixedRectangle;
+    QVector<QLine> m_alignmentLines;
     bool m_isDragging{false};
 
 private:
     void initialize();
+    void applyPalette();
     void hideAll();
     void setOpacity(float opacity);
     void setVisibility(const RenderData& renderData);
+    void applyAlignmentLines(const QVector<QLine>& lines);
     void onFixedLinesChanged(int index, const QPointF &point);
 
     template<typename T>
@@ -0,0 +1,300 @@
+#include <QApplication>
+#include <QDesktopWidget>
+#include <QScreen>
+#include <vector>
+
+#include "screencapturer.h"
+#include "profiler.h"
+
+#ifdef SPM_HAVE_XSHM
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#endif
+
+const int ScreenCapturer::kMaxSegments;
+
+#ifdef SPM_HAVE_XSHM
+namespace {
+struct Connection {
+    Display* display{nullptr};
+
+    ~Connection()
+    {
+        XCloseDisplay(display);
+    }
+};
+}
+#endif
+
+// Segments are shared by the capturer and the images grabbed into them, so a
+// segment outlives the capturer until the last image using it is released.
+struct ScreenCapturer::Segment {
+#ifdef SPM_HAVE_XSHM
+    QSharedPointer<Connection> connection;
+    XShmSegmentInfo info{};
+    XImage* image{nullptr};
+    bool isAttached{false};
+#endif
+    QSize size;
+    QAtomicInt isBusy{0};
+    QSharedPointer<Segment> self;
+
+    ~Segment()
+    {
+#ifdef SPM_HAVE_XSHM
+        if (isAttached)
+        {
+            XShmDetach(connection->display, &info);
+        }
+
+        if (image)
+        {
+            XDestroyImage(image);
+        }
+
+        if (info.shmaddr && info.shmaddr != reinterpret_cast<char*>(-1))
+        {
+            shmdt(info.shmaddr);
+        }
+#endif
+    }
+};
+
+struct ScreenCapturer::Data {
+#ifdef SPM_HAVE_XSHM
+    QSharedPointer<Connection> connection;
+    Display* display{nullptr};
+    ::Window root{0};
+    Visual* visual{nullptr};
+    int depth{0};
+#endif
+    QRect rootRect;
+    std::vector<QSharedPointer<Segment>> segments;
+};
+
+ScreenCapturer::ScreenCapturer(bool isSharedMemoryAllowed)
+    : d(new Data)
+{
+#ifdef SPM_HAVE_XSHM
+    if (!isSharedMemoryAllowed || QGuiApplication::platformName() != "xcb")
+    {
+        return;
+    }
+
+    d->display = XOpenDisplay(nullptr);
+
+    if (!d->display)
+    {
+        return;
+    }
+
+    auto screen = DefaultScreen(d->display);
+    d->root = RootWindow(d->display, screen);
+    d->visual = DefaultVisual(d->display, screen);
+    d->depth = DefaultDepth(d->display, screen);
+    d->rootRect = QRect(0, 0, DisplayWidth(d->display, screen), DisplayHeight(d->display, screen));
+
+    auto isLocal = DisplayString(d->display)[0] == ':';
+    auto isRgb32 = (d->depth == 24 || d->depth == 32) &&
+            d->visual->red_mask == 0xff0000 &&
+            d->visual->green_mask == 0xff00 &&
+            d->visual->blue_mask == 0xff;
+
+    if (!isLocal || !isRgb32 || !XShmQueryExtension(d->display))
+    {
+        XCloseDisplay(d->display);
+        d->display = nullptr;
+        return;
+    }
+
+    d->connection = QSharedPointer<Connection>::create();
+    d->connection->display = d->display;
+#else
+    Q_UNUSED(isSharedMemoryAllowed)
+#endif
+}
+
+ScreenCapturer::~ScreenCapturer()
+{
+}
+
+void ScreenCapturer::initializeThreads()
+{
+#ifdef SPM_HAVE_XSHM
+    XInitThreads();
+#endif
+}
+
+QImage ScreenCapturer::grab(const QRect& rect)
+{
+    auto image = isSharedMemoryAvailable() ? grabSharedMemory(rect) : QImage{};
+
+    return image.isNull() ? grabQt(rect) : image;
+}
+
+bool ScreenCapturer::isSharedMemoryAvailable() const
+{
+#ifdef SPM_HAVE_XSHM
+    return d->display && qFuzzyCompare(QGuiApplication::primaryScreen()->devicePixelRatio(), 1.0);
+#else
+    return false;
+#endif
+}
+
+QImage ScreenCapturer::grabSharedMemory(const QRect& rect)
+{
+#ifdef SPM_HAVE_XSHM
+    if (!d->display)
+    {
+        return {};
+    }
+
+    if (!d->rootRect.contains(rect))
+    {
+        XWindowAttributes attributes;
+
+        if (XGetWindowAttributes(d->display, d->root, &attributes))
+        {
+            d->rootRect = QRect(0, 0, attributes.width, attributes.height);
+        }
+    }
+
+    if (rect.isEmpty() || !d->rootRect.contains(rect))
+    {
+        return {};
+    }
+
+    auto segment = acquireSegment(rect.size());
+
+    if (!segment)
+    {
+        return {};
+    }
+
+    segment->self = segment;
+
+    if (!XShmGetImage(d->display, d->root, segment->image, rect.x(), rect.y(), AllPlanes))
+    {
+        releaseSegment(segment.data());
+        return {};
+    }
+
+    return QImage(reinterpret_cast<const uchar*>(segment->image->data),
+                  rect.width(), rect.height(), segment->image->bytes_per_line,
+                  QImage::Format_RGB32, &ScreenCapturer::releaseSegment, segment.data());
+#else
+    Q_UNUSED(rect)
+    return {};
+#endif
+}
+
+QImage ScreenCapturer::grabQt(const QRect& rect)
+{
+    auto screen = QGuiApplication::primaryScreen();
+    auto winId = QApplication::desktop()->winId();
+
+    auto image = screen->grabWindow(winId, rect.x(), rect.y(), rect.width(), rect.height()).toImage();
+    Profiler::countBufferAllocation(image.sizeInBytes());
+
+    return image;
+}
+
+QSharedPointer<ScreenCapturer::Segment> ScreenCapturer::acquireSegment(const QSize& size)
+{
+    for (const auto& segment : d->segments)
+    {
+        if (segment->size == size && segment->isBusy.testAndSetAcquire(0, 1))
+        {
+            return segment;
+        }
+    }
+
+    for (auto it = d->segments.begin(); it != d->segments.end(); ++it)
+    {
+        if ((*it)->isBusy.testAndSetAcquire(0, 1))
+        {
+            auto segment = createSegment(size);
+
+            if (segment)
+            {
+                *it = segment;
+            }
+            else
+            {
+                d->segments.erase(it);
+            }
+
+            return segment;
+        }
+    }
+
+    if (int(d->segments.size()) >= kMaxSegments)
+    {
+        return {};
+    }
+
+    auto segment = createSegment(size);
+
+    if (segment)
+    {
+        d->segments.push_back(segment);
+    }
+
+    return segment;
+}
+
+QSharedPointer<ScreenCapturer::Segment> ScreenCapturer::createSegment(const QSize& size)
+{
+#ifdef SPM_HAVE_XSHM
+    auto segment = QSharedPointer<Segment>::create();
+    segment->connection = d->connection;
+    segment->size = size;
+    segment->isBusy.storeRelaxed(1);
+    segment->image = XShmCreateImage(d->display, d->visual, unsigned(d->depth), ZPixmap, nullptr,
+                                     &segment->info, unsigned(size.width()), unsigned(size.height()));
+
+    if (!segment->image || segment->image->bits_per_pixel != 32 || segment->image->byte_order != LSBFirst)
+    {
+        return {};
+    }
+
+    auto bytes = qint64(segment->image->bytes_per_line) * size.height();
+    segment->info.shmid = shmget(IPC_PRIVATE, size_t(bytes), IPC_CREAT | 0600);
+    segment->info.shmaddr = segment->info.shmid < 0
+            ? reinterpret_cast<char*>(-1)
+            : static_cast<char*>(shmat(segment->info.shmid, nullptr, 0));
+    segment->info.readOnly = False;
+    segment->image->data = segment->info.shmaddr;
+    segment->isAttached = segment->info.shmaddr != reinterpret_cast<char*>(-1) &&
+            XShmAttach(d->display, &segment->info);
+
+    if (segment->info.shmid >= 0)
+    {
+        XSync(d->display, False);
+        shmctl(segment->info.shmid, IPC_RMID, nullptr);
+    }
+
+    if (!segment->isAttached)
+    {
+        return {};
+    }
+
+    Profiler::countBufferAllocation(bytes);
+
+    return segment;
+#else
+    Q_UNUSED(size)
+    return {};
+#endif
+}
+
+void ScreenCapturer::releaseSegment(void* info)
+{
+    auto segment = static_cast<Segment*>(info);
+    auto self = std::move(segment->self);
+
+    segment->isBusy.storeRelease(0);
+}
@@ -0,0 +1,34 @@
+#ifndef SCREENCAPTURER_H
+#define SCREENCAPTURER_H
+
+#include <QImage>
+#include <QScopedPointer>
+#include <QSharedPointer>
+
+class ScreenCapturer
+{
+public:
+    static const int kMaxSegments{4};
+
+    explicit ScreenCapturer(bool isSharedMemoryAllowed = true);
+    ~ScreenCapturer();
+
+    static void initializeThreads();
+
+    QImage grab(const QRect& rect);
+    QImage grabSharedMemory(const QRect& rect);
+    QImage grabQt(const QRect& rect);
+    bool isSharedMemoryAvailable() const;
+
+private:
+    struct Segment;
+    struct Data;
+    QScopedPointer<Data> d;
+
+private:
+    QSharedPointer<Segment> acquireSegment(const QSize& size);
+    QSharedPointer<Segment> createSegment(const QSize& size);
+    static void releaseSegment(void* info);
+};
+
+#endif // SCREENCAPTURER_H
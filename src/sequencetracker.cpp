@@ -0,0 +1,309 @@
+#include <QCollator>
+#include <QDir>
+#include <QFileInfo>
+#include <QIODevice>
+#include <QtConcurrent>
+#include <algorithm>
+
+#include "sequencetracker.h"
+#include "calculator.h"
+
+const int SequenceTracker::kFrameWindow;
+
+SequenceTracker::SequenceTracker()
+{
+}
+
+bool SequenceTracker::open(const QString& source, const QSize& rawFrameSize)
+{
+    QFileInfo info(source);
+
+    if (info.isDir())
+    {
+        QCollator collator;
+        collator.setNumericMode(true);
+
+        m_kind = Kind::Images;
+        m_files.clear();
+
+        for (const auto& name : QDir(source).entryList({"*.png"}, QDir::Files))
+        {
+            m_files.push_back(QDir(source).filePath(name));
+        }
+
+        std::sort(m_files.begin(), m_files.end(), collator);
+
+        if (m_files.isEmpty())
+        {
+            m_error = "No PNG frames in " + source;
+            return false;
+        }
+
+        return true;
+    }
+
+    m_file.setFileName(source);
+
+    if (!m_file.open(QIODevice::ReadOnly))
+    {
+        m_error = m_file.errorString();
+        return false;
+    }
+
+    if (info.suffix().compare("y4m", Qt::CaseInsensitive) == 0)
+    {
+        m_kind = Kind::Y4m;
+        return openY4m();
+    }
+
+    if (rawFrameSize.isEmpty())
+    {
+        m_error = "The frame size of a raw RGB stream is required";
+        return false;
+    }
+
+    m_kind = Kind::Rgb;
+    m_frameSize = rawFrameSize;
+    m_frameBytes = qint64(rawFrameSize.width()) * rawFrameSize.height() * 3;
+
+    return true;
+}
+
+bool SequenceTracker::openY4m()
+{
+    auto tokens = m_file.readLine().trimmed().split(' ');
+
+    if (tokens.isEmpty() || tokens.front() != "YUV4MPEG2")
+    {
+        m_error = "Not a YUV4MPEG2 stream";
+        return false;
+    }
+
+    QByteArray chroma{"420"};
+
+    for (const auto& token : tokens)
+    {
+        if (token.startsWith('W'))
+        {
+            m_frameSize.setWidth(token.mid(1).toInt());
+        }
+        else if (token.startsWith('H'))
+        {
+            m_frameSize.setHeight(token.mid(1).toInt());
+        }
+        else if (token.startsWith('C'))
+        {
+            chroma = token.mid(1);
+        }
+    }
+
+    auto planeSize = qint64(m_frameSize.width()) * m_frameSize.height();
+    auto chromaSize = qint64((m_frameSize.width() + 1) / 2) * ((m_frameSize.height() + 1) / 2);
+
+    if (chroma.startsWith("420"))
+    {
+        m_chroma = Chroma::Yuv420;
+        m_frameBytes = planeSize + 2 * chromaSize;
+    }
+    else if (chroma == "444")
+    {
+        m_chroma = Chroma::Yuv444;
+        m_frameBytes = 3 * planeSize;
+    }
+    else if (chroma == "mono")
+    {
+        m_chroma = Chroma::Mono;
+        m_frameBytes = planeSize;
+    }
+    else
+    {
+        m_error = "Unsupported YUV4MPEG2 chroma " + QString(chroma);
+        return false;
+    }
+
+    if (m_frameSize.isEmpty())
+    {
+        m_error = "Invalid YUV4MPEG2 frame size";
+        return false;
+    }
+
+    return true;
+}
+
+int SequenceTracker::track(const QPoint& seed, const QRect& pinnedRect, bool isPinned, QIODevice* csv)
+{
+    auto pos = seed;
+    int count{0};
+    QVector<Frame> frames;
+
+    csv->write("frame,x,y,width,height,horizontal,vertical\n");
+
+    while (readFrames(frames))
+    {
+        auto images = QtConcurrent::blockingMapped<QVector<QImage>>(frames, [this](const Frame& frame){
+            return decode(frame);
+        });
+
+        for (const auto& image : images)
+        {
+            auto sample = measure(count++, image, pos, pinnedRect, isPinned);
+
+            if (sample.isFound)
+            {
+                pos = sample.rect.topLeft() + QPoint(sample.rect.width() / 2, sample.rect.height() / 2);
+            }
+
+            csv->write(toCsv(sample));
+        }
+    }
+
+    return count;
+}
+
+QString SequenceTracker::errorString() const
+{
+    return m_error;
+}
+
+bool SequenceTracker::readFrames(QVector<Frame>& frames)
+{
+    frames.clear();
+
+    while (frames.size() < kFrameWindow)
+    {
+        Frame frame;
+
+        if (m_kind == Kind::Images)
+        {
+            if (m_nextFrame >= m_files.size())
+            {
+                break;
+            }
+
+            frame.fileName = m_files[m_nextFrame++];
+        }
+        else
+        {
+            if (m_kind == Kind::Y4m && !m_file.readLine().startsWith("FRAME"))
+            {
+                break;
+            }
+
+            frame.data = m_file.read(m_frameBytes);
+
+            if (frame.data.size() < m_frameBytes)
+            {
+                break;
+            }
+        }
+
+        frames.push_back(frame);
+    }
+
+    return !frames.isEmpty();
+}
+
+QImage SequenceTracker::decode(const Frame& frame) const
+{
+    switch (m_kind)
+    {
+    case Kind::Images:
+        return QImage(frame.fileName).convertToFormat(QImage::Format_RGB32);
+    case Kind::Y4m:
+        return fromY4m(frame.data);
+    case Kind::Rgb:
+        return QImage(reinterpret_cast<const uchar*>(frame.data.constData()), m_frameSize.width(),
+                      m_frameSize.height(), m_frameSize.width() * 3, QImage::Format_RGB888)
+                .convertToFormat(QImage::Format_RGB32);
+    }
+
+    return {};
+}
+
+QImage SequenceTracker::fromY4m(const QByteArray& data) const
+{
+    QImage image(m_frameSize, QImage::Format_RGB32);
+
+    if (image.isNull())
+    {
+        return image;
+    }
+
+    auto width = m_frameSize.width();
+    auto height = m_frameSize.height();
+    auto isSubsampled = m_chroma == Chroma::Yuv420;
+    auto chromaWidth = isSubsampled ? (width + 1) / 2 : width;
+    auto chromaHeight = isSubsampled ? (height + 1) / 2 : height;
+    auto lumaPlane = reinterpret_cast<const uchar*>(data.constData());
+    auto uPlane = lumaPlane + qint64(width) * height;
+    auto vPlane = uPlane + qint64(chromaWidth) * chromaHeight;
+
+    for (int y = 0; y < height; ++y)
+    {
+        auto line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        auto luma = lumaPlane + qint64(y) * width;
+        auto chromaOffset = qint64(isSubsampled ? y / 2 : y) * chromaWidth;
+
+        for (int x = 0; x < width; ++x)
+        {
+            auto c = 298 * (luma[x] - 16);
+            auto d = 0;
+            auto e = 0;
+
+            if (m_chroma != Chroma::Mono)
+            {
+                auto chromaX = isSubsampled ? x / 2 : x;
+                d = uPlane[chromaOffset + chromaX] - 128;
+                e = vPlane[chromaOffset + chromaX] - 128;
+            }
+
+            line[x] = qRgb(qBound(0, (c + 409 * e + 128) >> 8, 255),
+                           qBound(0, (c - 100 * d - 208 * e + 128) >> 8, 255),
+                           qBound(0, (c + 516 * d + 128) >> 8, 255));
+        }
+    }
+
+    return image;
+}
+
+SequenceTracker::Sample SequenceTracker::measure(int index, const QImage& image, const QPoint& seed,
+                                                 const QRect& pinnedRect, bool isPinned)
+{
+    Sample sample;
+    sample.frame = index;
+
+    if (!image.rect().contains(seed))
+    {
+        return sample;
+    }
+
+    sample.rect = Calculator::calculateCursorRectangle(seed, image);
+    sample.isFound = true;
+
+    if (isPinned)
+    {
+        auto lines = Calculator::calculateMeasureLines(sample.rect, pinnedRect);
+        sample.horizontal = lines[1].dx() > 0 ? lines[1].dx() + 1 : 0;
+        sample.vertical = lines[0].dy() > 0 ? lines[0].dy() + 1 : 0;
+    }
+
+    return sample;
+}
+
+QByteArray SequenceTracker::toCsv(const Sample& sample)
+{
+    if (!sample.isFound)
+    {
+        return QByteArray::number(sample.frame) + ",,,,,,\n";
+    }
+
+    return QString("%1,%2,%3,%4,%5,%6,%7\n")
+            .arg(sample.frame)
+            .arg(sample.rect.x())
+            .arg(sample.rect.y())
+            .arg(sample.rect.width() + 1)
+            .arg(sample.rect.height() + 1)
+            .arg(sample.horizontal)
+            .arg(sample.vertical)
+            .toUtf8();
+}
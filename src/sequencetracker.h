@@ -0,0 +1,67 @@
+#ifndef SEQUENCETRACKER_H
+#define SEQUENCETRACKER_H
+
+#include <QFile>
+#include <QImage>
+#include <QStringList>
+#include <QVector>
+
+class QIODevice;
+
+class SequenceTracker
+{
+public:
+    static const int kFrameWindow{16};
+
+    struct Sample {
+        int frame{0};
+        QRect rect;
+        int horizontal{0};
+        int vertical{0};
+        bool isFound{false};
+    };
+
+    SequenceTracker();
+
+    bool open(const QString& source, const QSize& rawFrameSize);
+    int track(const QPoint& seed, const QRect& pinnedRect, bool isPinned, QIODevice* csv);
+    QString errorString() const;
+
+private:
+    enum class Kind {
+        Images,
+        Y4m,
+        Rgb
+    };
+
+    enum class Chroma {
+        Yuv420,
+        Yuv444,
+        Mono
+    };
+
+    struct Frame {
+        QString fileName;
+        QByteArray data;
+    };
+
+    Kind m_kind{Kind::Images};
+    Chroma m_chroma{Chroma::Yuv420};
+    QStringList m_files;
+    QFile m_file;
+    QSize m_frameSize;
+    qint64 m_frameBytes{0};
+    int m_nextFrame{0};
+    QString m_error;
+
+private:
+    bool openY4m();
+    bool readFrames(QVector<Frame>& frames);
+    QImage decode(const Frame& frame) const;
+    QImage fromY4m(const QByteArray& data) const;
+    static Sample measure(int index, const QImage& image, const QPoint& seed,
+                          const QRect& pinnedRect, bool isPinned);
+    static QByteArray toCsv(const Sample& sample);
+};
+
+#endif // SEQUENCETRACKER_H
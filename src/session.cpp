@@ -0,0 +1,179 @@
+#include <QFile>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "session.h"
+
+bool Session::save(const QString& fileName, const RenderData& renderData, const EdgeMap& edgeMap)
+{
+    if (renderData.screenImage.isNull())
+    {
+        return false;
+    }
+
+    const auto& img = renderData.screenImage.format() == QImage::Format_RGB32
+            ? renderData.screenImage
+            : renderData.screenImage.convertToFormat(QImage::Format_RGB32);
+
+    std::vector<std::pair<Section, const QByteArray*>> sections;
+
+    if (edgeMap.size() == img.size())
+    {
+        sections.push_back({{quint32(SectionKind::HorizontalEdges), EdgeMap::kVersion, 0, 0},
+                            &edgeMap.horizontalData()});
+        sections.push_back({{quint32(SectionKind::VerticalEdges), EdgeMap::kVersion, 0, 0},
+                            &edgeMap.verticalData()});
+    }
+
+    Header header;
+    std::memcpy(header.magic, "SPMS", sizeof(header.magic));
+    header.version = kFormatVersion;
+    header.width = img.width();
+    header.height = img.height();
+    header.bytesPerLine = img.bytesPerLine();
+    header.format = img.format();
+    header.cursorPoint[0] = renderData.cursorPoint.x();
+    header.cursorPoint[1] = renderData.cursorPoint.y();
+    header.fixedRectangle[0] = renderData.fixedRectangle.x();
+    header.fixedRectangle[1] = renderData.fixedRectangle.y();
+    header.fixedRectangle[2] = renderData.fixedRectangle.width();
+    header.fixedRectangle[3] = renderData.fixedRectangle.height();
+    header.flags = renderData.isFixedRectPresent ? FixedRectPresent : 0;
+    header.sectionCount = quint32(sections.size());
+
+    auto imageSize = qint64(img.bytesPerLine()) * img.height();
+    auto pos = qint64(sizeof(Header) + sizeof(Section) * sections.size());
+
+    header.imageOffset = quint64(align(pos, kImageAlignment));
+    pos = qint64(header.imageOffset) + imageSize;
+
+    for (auto& section : sections)
+    {
+        pos = align(pos, kSectionAlignment);
+        section.first.offset = quint64(pos);
+        section.first.size = quint64(section.second->size());
+        pos += section.second->size();
+    }
+
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        return false;
+    }
+
+    bool isWritten = file.write(reinterpret_cast<const char*>(&header), sizeof(Header)) == sizeof(Header);
+
+    for (const auto& section : sections)
+    {
+        isWritten = isWritten &&
+                file.write(reinterpret_cast<const char*>(&section.first), sizeof(Section)) == sizeof(Section);
+    }
+
+    isWritten = isWritten &&
+            file.seek(qint64(header.imageOffset)) &&
+            file.write(reinterpret_cast<const char*>(img.constBits()), imageSize) == imageSize;
+
+    for (const auto& section : sections)
+    {
+        isWritten = isWritten &&
+                file.seek(qint64(section.first.offset)) &&
+                file.write(*section.second) == section.second->size();
+    }
+
+    return isWritten;
+}
+
+bool Session::load(const QString& fileName, RenderData& renderData, EdgeMap& edgeMap)
+{
+    auto file = new QFile(fileName);
+
+    if (!file->open(QIODevice::ReadOnly) || file->size() < qint64(sizeof(Header)))
+    {
+        delete file;
+        return false;
+    }
+
+    auto fileSize = quint64(file->size());
+    auto data = file->map(0, file->size());
+
+    if (!data)
+    {
+        delete file;
+        return false;
+    }
+
+    Header header;
+    std::memcpy(&header, data, sizeof(Header));
+
+    auto format = QImage::Format(header.format);
+    auto imageSize = quint64(qMax(header.bytesPerLine, 0)) * quint64(qMax(header.height, 0));
+    auto sectionsSize = quint64(header.sectionCount) * sizeof(Section);
+
+    if (std::memcmp(header.magic, "SPMS", sizeof(header.magic)) != 0 ||
+        header.version != kFormatVersion ||
+        (format != QImage::Format_RGB32 && format != QImage::Format_ARGB32_Premultiplied) ||
+        header.width <= 0 || header.height <= 0 ||
+        header.width > std::numeric_limits<qint32>::max() / 4 ||
+        header.bytesPerLine < header.width * 4 ||
+        !isInside(sizeof(Header), sectionsSize, fileSize) ||
+        !isInside(header.imageOffset, imageSize, fileSize))
+    {
+        delete file;
+        return false;
+    }
+
+    QByteArray horizontal;
+    QByteArray vertical;
+
+    for (quint32 i = 0; i < header.sectionCount; ++i)
+    {
+        Section section;
+        std::memcpy(&section, data + sizeof(Header) + i * sizeof(Section), sizeof(Section));
+
+        if (section.version != EdgeMap::kVersion ||
+            section.size > quint64(std::numeric_limits<int>::max()) ||
+            !isInside(section.offset, section.size, fileSize))
+        {
+            continue;
+        }
+
+        auto sectionData = reinterpret_cast<const char*>(data + section.offset);
+
+        if (section.kind == quint32(SectionKind::HorizontalEdges))
+        {
+            horizontal = QByteArray(sectionData, int(section.size));
+        }
+        else if (section.kind == quint32(SectionKind::VerticalEdges))
+        {
+            vertical = QByteArray(sectionData, int(section.size));
+        }
+    }
+
+    renderData.screenImage = QImage(static_cast<const uchar*>(data + header.imageOffset), header.width, header.height,
+                                    header.bytesPerLine, format, &Session::releaseMapping, file);
+    renderData.cursorPoint = {header.cursorPoint[0], header.cursorPoint[1]};
+    renderData.fixedRectangle = {header.fixedRectangle[0], header.fixedRectangle[1],
+                                 header.fixedRectangle[2], header.fixedRectangle[3]};
+    renderData.isFixedRectPresent = header.flags & FixedRectPresent;
+
+    edgeMap = EdgeMap::fromData(renderData.screenImage.size(), horizontal, vertical);
+
+    return true;
+}
+
+bool Session::isInside(quint64 offset, quint64 size, quint64 fileSize)
+{
+    return offset <= fileSize && size <= fileSize - offset;
+}
+
+qint64 Session::align(qint64 pos, qint64 alignment)
+{
+    return (pos + alignment - 1) / alignment * alignment;
+}
+
+void Session::releaseMapping(void* info)
+{
+    delete static_cast<QFile*>(info);
+}
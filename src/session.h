@@ -0,0 +1,55 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <QString>
+
+#include "data.h"
+#include "edgemap.h"
+
+class Session
+{
+    static constexpr quint32 kFormatVersion{1};
+    static constexpr qint64 kImageAlignment{4096};
+    static constexpr qint64 kSectionAlignment{64};
+
+    enum class SectionKind : quint32 {
+        HorizontalEdges = 1,
+        VerticalEdges = 2
+    };
+
+    struct Header {
+        char magic[4];
+        quint32 version;
+        qint32 width;
+        qint32 height;
+        qint32 bytesPerLine;
+        quint32 format;
+        quint64 imageOffset;
+        qint32 cursorPoint[2];
+        qint32 fixedRectangle[4];
+        quint32 flags;
+        quint32 sectionCount;
+    };
+
+    struct Section {
+        quint32 kind;
+        quint32 version;
+        quint64 offset;
+        quint64 size;
+    };
+
+    enum Flags : quint32 {
+        FixedRectPresent = 0x1
+    };
+
+public:
+    static bool save(const QString& fileName, const RenderData& renderData, const EdgeMap& edgeMap);
+    static bool load(const QString& fileName, RenderData& renderData, EdgeMap& edgeMap);
+
+private:
+    static bool isInside(quint64 offset, quint64 size, quint64 fileSize);
+    static qint64 align(qint64 pos, qint64 alignment);
+    static void releaseMapping(void* info);
+};
+
+#endif // SESSION_H
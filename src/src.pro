@@ -0,0 +1,100 @@
+QT       += core gui
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets concurrent network
+
+CONFIG += c++11
+
+TARGET = ScreenPixelMeasurer
+
+# You can make your code fail to compile if it uses deprecated APIs.
+# In order to do so, uncomment the following line.
+#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+SOURCES += \
+    alignmentmap.cpp \
+    bufferpool.cpp \
+    calculator.cpp \
+    colorstats.cpp \
+    diffmap.cpp \
+    edgemap.cpp \
+    framering.cpp \
+    items.cpp \
+    scene.cpp \
+    screencapturer.cpp \
+    main.cpp \
+    measurementserver.cpp \
+    pngreader.cpp \
+    pngwriter.cpp \
+    profiler.cpp \
+    recorder.cpp \
+    redline.cpp \
+    replayer.cpp \
+    sequencetracker.cpp \
+    session.cpp \
+    tiledimage.cpp \
+    transitiontable.cpp \
+    view.cpp \
+    window.cpp
+
+HEADERS += \
+    alignmentmap.h \
+    bufferpool.h \
+    calculationstage.h \
+    calculator.h \
+    colorstats.h \
+    data.h \
+    diffmap.h \
+    edgemap.h \
+    framering.h \
+    items.h \
+    measurementserver.h \
+    pngreader.h \
+    pngwriter.h \
+    profiler.h \
+    recorder.h \
+    redline.h \
+    replayer.h \
+    scene.h \
+    screencapturer.h \
+    sequencetracker.h \
+    session.h \
+    tiledimage.h \
+    transitiontable.h \
+    view.h \
+    window.h
+
+unix|win32-g++ {
+    DEFINES += SPM_HAVE_ZLIB
+    LIBS += -lz
+}
+
+unix:!macx: LIBS += -lrt
+
+CONFIG(debug, debug|release)|count_allocations {
+    DEFINES += SPM_COUNT_ALLOCATIONS
+    SOURCES += allocationhook.cpp
+}
+
+unix:!macx:packagesExist(x11 xext) {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += x11 xext
+    DEFINES += SPM_HAVE_XSHM
+}
+
+INCLUDEPATH += $$PWD/../core
+DEPENDPATH += $$PWD/../core
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../core/release/ -lmeasurercore
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../core/debug/ -lmeasurercore
+else:unix: LIBS += -L$$OUT_PWD/../core/ -lmeasurercore
+
+win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../core/release/libmeasurercore.a
+else:win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../core/debug/libmeasurercore.a
+else:win32:!win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../core/release/measurercore.lib
+else:win32:!win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../core/debug/measurercore.lib
+else:unix: PRE_TARGETDEPS += $$OUT_PWD/../core/libmeasurercore.a
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,390 @@
+#include <QImageReader>
+#include <QTemporaryFile>
+#include <QMutex>
+#include <QtConcurrent>
+#include <atomic>
+#include <cstring>
+#include <list>
+#include <numeric>
+#include <vector>
+
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#endif
+
+#include "tiledimage.h"
+#include "pngreader.h"
+
+constexpr int TiledImage::kTileSize;
+
+namespace {
+const qint64 kTileBytes = qint64(TiledImage::kTileSize) * TiledImage::kTileSize * sizeof(QRgb);
+}
+
+struct TiledImage::Data {
+    QTemporaryFile file;
+    uchar* tiles{nullptr};
+    QSize size;
+    int columns{0};
+    int rows{0};
+    qint64 memoryLimit{0};
+    qint64 residentBytes{0};
+
+    QMutex mutex;
+    std::list<int> lru;
+    std::vector<std::list<int>::iterator> lruPos;
+    std::vector<char> isResident;
+
+    void release(int index)
+    {
+#ifdef Q_OS_UNIX
+        madvise(tiles + index * kTileBytes, size_t(kTileBytes), MADV_DONTNEED);
+#else
+        Q_UNUSED(index)
+#endif
+    }
+};
+
+TiledImage::TiledImage()
+{
+}
+
+TiledImage TiledImage::load(const QString& fileName, qint64 memoryLimit)
+{
+    TiledImage image;
+    QImageReader reader(fileName);
+    auto size = reader.size();
+
+    if (!size.isValid())
+    {
+        image.m_errorString = reader.errorString();
+        return image;
+    }
+
+    auto imageBytes = qint64(size.width()) * size.height() * qint64(sizeof(QRgb));
+    auto data = create(size, memoryLimit);
+
+    if (!data)
+    {
+        image.m_errorString = "Cannot create the tile store";
+        return image;
+    }
+
+    auto isStored = false;
+
+    if (imageBytes <= memoryLimit)
+    {
+        isStored = loadFull(*data, reader, image.m_errorString);
+    }
+    else if (reader.format() == "png")
+    {
+        isStored = loadPng(*data, fileName, image.m_errorString);
+    }
+    else if (reader.supportsOption(QImageIOHandler::ClipRect))
+    {
+        isStored = loadBands(*data, fileName, image.m_errorString);
+    }
+    else
+    {
+        image.m_errorString = QString("A %1x%2 %3 image cannot be decoded by parts within %4 MB")
+                .arg(size.width()).arg(size.height()).arg(QString(reader.format()))
+                .arg(memoryLimit / (1024 * 1024));
+    }
+
+    if (isStored)
+    {
+        image.d = data;
+    }
+
+    return image;
+}
+
+QString TiledImage::errorString() const
+{
+    return m_errorString;
+}
+
+QSharedPointer<TiledImage::Data> TiledImage::create(const QSize& size, qint64 memoryLimit)
+{
+    auto data = QSharedPointer<Data>::create();
+    data->size = size;
+    data->columns = (size.width() + kTileSize - 1) / kTileSize;
+    data->rows = (size.height() + kTileSize - 1) / kTileSize;
+    data->memoryLimit = memoryLimit;
+    data->lruPos.resize(size_t(data->columns) * data->rows);
+    data->isResident.assign(size_t(data->columns) * data->rows, 0);
+
+    if (!data->file.open() ||
+        !data->file.resize(kTileBytes * data->columns * data->rows))
+    {
+        return {};
+    }
+
+    data->tiles = data->file.map(0, data->file.size());
+
+    return data->tiles ? data : QSharedPointer<Data>{};
+}
+
+bool TiledImage::loadFull(Data& data, QImageReader& reader, QString& error)
+{
+    auto full = reader.read();
+
+    if (full.isNull())
+    {
+        error = reader.errorString();
+        return false;
+    }
+
+    full = std::move(full).convertToFormat(QImage::Format_RGB32);
+
+    QVector<int> bands(data.rows);
+    std::iota(bands.begin(), bands.end(), 0);
+    std::atomic<bool> isStored{true};
+
+    QtConcurrent::blockingMap(bands, [&](int row){
+        if (!storeBand(data, full, row * kTileSize, row))
+        {
+            isStored = false;
+        }
+    });
+
+    if (!isStored)
+    {
+        error = "The decoded image does not match its header size";
+    }
+
+    return isStored;
+}
+
+bool TiledImage::loadPng(Data& data, const QString& fileName, QString& error)
+{
+    PngReader png;
+
+    if (!png.open(fileName))
+    {
+        error = png.errorString();
+        return false;
+    }
+
+    if (png.size() != data.size)
+    {
+        error = "The PNG header does not match the image size";
+        return false;
+    }
+
+    QImage band(data.size.width(), kTileSize, QImage::Format_RGB32);
+
+    if (band.isNull())
+    {
+        error = "Cannot allocate a PNG band";
+        return false;
+    }
+
+    for (int row = 0; row < data.rows; ++row)
+    {
+        auto height = qMin(kTileSize, data.size.height() - row * kTileSize);
+
+        if (height < kTileSize)
+        {
+            band = band.copy(0, 0, band.width(), height);
+        }
+
+        if (!png.read(band))
+        {
+            error = png.errorString();
+            return false;
+        }
+
+        storeBand(data, band, 0, row);
+    }
+
+    return true;
+}
+
+bool TiledImage::loadBands(Data& data, const QString& fileName, QString& error)
+{
+    auto rowBytes = qint64(data.size.width()) * kTileSize * qint64(sizeof(QRgb));
+    auto bandRows = int(qBound<qint64>(1, data.memoryLimit / 2 / rowBytes, data.rows));
+
+    for (int row = 0; row < data.rows; row += bandRows)
+    {
+        QImageReader reader(fileName);
+        reader.setClipRect(QRect(0, row * kTileSize, data.size.width(), bandRows * kTileSize) &
+                           QRect({0, 0}, data.size));
+        auto band = reader.read().convertToFormat(QImage::Format_RGB32);
+
+        if (band.isNull())
+        {
+            error = reader.errorString();
+            return false;
+        }
+
+        for (int i = 0; i < bandRows && row + i < data.rows; ++i)
+        {
+            if (!storeBand(data, band, i * kTileSize, row + i))
+            {
+                error = "The decoded band does not match the requested size";
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool TiledImage::isNull() const
+{
+    return !d;
+}
+
+QSize TiledImage::size() const
+{
+    return d ? d->size : QSize{};
+}
+
+QRect TiledImage::rect() const
+{
+    return {{0, 0}, size()};
+}
+
+int TiledImage::columns() const
+{
+    return d ? d->columns : 0;
+}
+
+int TiledImage::rows() const
+{
+    return d ? d->rows : 0;
+}
+
+qint64 TiledImage::residentBytes() const
+{
+    if (!d)
+    {
+        return 0;
+    }
+
+    QMutexLocker locker(&d->mutex);
+    return d->residentBytes;
+}
+
+QImage TiledImage::tile(int column, int row) const
+{
+    return QImage(touch(column, row), kTileSize, kTileSize,
+                  kTileSize * int(sizeof(QRgb)), QImage::Format_RGB32);
+}
+
+QRgb TiledImage::pixel(const QPoint& pos) const
+{
+    auto tile = reinterpret_cast<const QRgb*>(touch(pos.x() / kTileSize, pos.y() / kTileSize));
+
+    return tile[(pos.y() % kTileSize) * kTileSize + pos.x() % kTileSize];
+}
+
+int TiledImage::beamTo(int startPos, int endPos, int coord, int step,
+                       Qt::Orientation orientation, const QRgb& color) const
+{
+    auto isHorizontal = orientation == Qt::Horizontal;
+    auto length = isHorizontal ? d->size.width() : d->size.height();
+    auto breadth = isHorizontal ? d->size.height() : d->size.width();
+
+    if (coord < 0 || coord >= breadth)
+    {
+        return endPos;
+    }
+
+    auto stride = isHorizontal ? 1 : kTileSize;
+    auto lineOffset = (coord % kTileSize) * (isHorizontal ? kTileSize : 1);
+    auto pos = startPos + step;
+
+    while (pos != endPos && pos >= 0 && pos < length)
+    {
+        auto tilePos = pos / kTileSize;
+        auto tileStart = tilePos * kTileSize;
+        auto tileEnd = step > 0 ? qMin(tileStart + kTileSize, length) : tileStart - 1;
+        auto tile = isHorizontal ? touch(tilePos, coord / kTileSize)
+                                 : touch(coord / kTileSize, tilePos);
+        auto line = reinterpret_cast<const QRgb*>(tile) + lineOffset;
+
+        for (; pos != tileEnd && pos != endPos; pos += step)
+        {
+            if (line[(pos - tileStart) * stride] != color)
+            {
+                return pos - step;
+            }
+        }
+    }
+
+    return endPos;
+}
+
+bool TiledImage::operator==(const TiledImage& other) const
+{
+    return d == other.d;
+}
+
+bool TiledImage::operator!=(const TiledImage& other) const
+{
+    return d != other.d;
+}
+
+const uchar* TiledImage::touch(int column, int row) const
+{
+    QMutexLocker locker(&d->mutex);
+
+    auto index = row * d->columns + column;
+
+    if (d->isResident[size_t(index)])
+    {
+        d->lru.splice(d->lru.begin(), d->lru, d->lruPos[size_t(index)]);
+    }
+    else
+    {
+        d->lru.push_front(index);
+        d->lruPos[size_t(index)] = d->lru.begin();
+        d->isResident[size_t(index)] = 1;
+        d->residentBytes += kTileBytes;
+
+        while (d->residentBytes > d->memoryLimit && d->lru.size() > 1)
+        {
+            auto evicted = d->lru.back();
+            d->lru.pop_back();
+            d->isResident[size_t(evicted)] = 0;
+            d->residentBytes -= kTileBytes;
+            d->release(evicted);
+        }
+    }
+
+    return d->tiles + index * kTileBytes;
+}
+
+bool TiledImage::storeBand(Data& data, const QImage& img, int top, int row)
+{
+    auto height = qMin(kTileSize, data.size.height() - row * kTileSize);
+
+    if (img.width() < data.size.width() || top + height > img.height())
+    {
+        return false;
+    }
+
+    for (int column = 0; column < data.columns; ++column)
+    {
+        auto x = column * kTileSize;
+        auto width = qMin(kTileSize, data.size.width() - x);
+        auto tile = data.tiles + (row * data.columns + column) * kTileBytes;
+
+        for (int y = 0; y < height; ++y)
+        {
+            std::memcpy(tile + y * kTileSize * int(sizeof(QRgb)),
+                        img.constScanLine(top + y) + x * int(sizeof(QRgb)),
+                        size_t(width) * sizeof(QRgb));
+        }
+    }
+
+    for (int column = 0; column < data.columns; ++column)
+    {
+        data.release(row * data.columns + column);
+    }
+
+    return true;
+}
@@ -0,0 +1,48 @@
+#ifndef TILEDIMAGE_H
+#define TILEDIMAGE_H
+
+#include <QImage>
+#include <QSharedPointer>
+
+class QImageReader;
+
+class TiledImage
+{
+public:
+    static constexpr int kTileSize{256};
+
+    TiledImage();
+
+    static TiledImage load(const QString& fileName, qint64 memoryLimit);
+    QString errorString() const;
+
+    bool isNull() const;
+    QSize size() const;
+    QRect rect() const;
+    int columns() const;
+    int rows() const;
+    qint64 residentBytes() const;
+
+    QImage tile(int column, int row) const;
+    QRgb pixel(const QPoint& pos) const;
+    int beamTo(int startPos, int endPos, int coord, int step,
+               Qt::Orientation orientation, const QRgb& color) const;
+
+    bool operator==(const TiledImage& other) const;
+    bool operator!=(const TiledImage& other) const;
+
+private:
+    struct Data;
+    QSharedPointer<Data> d;
+    QString m_errorString;
+
+private:
+    const uchar* touch(int column, int row) const;
+    static QSharedPointer<Data> create(const QSize& size, qint64 memoryLimit);
+    static bool loadFull(Data& data, QImageReader& reader, QString& error);
+    static bool loadPng(Data& data, const QString& fileName, QString& error);
+    static bool loadBands(Data& data, const QString& fileName, QString& error);
+    static bool storeBand(Data& data, const QImage& band, int top, int row);
+};
+
+#endif // TILEDIMAGE_H
@@ -0,0 +1,120 @@
+#include <QtConcurrent>
+#include <numeric>
+
+#include "transitiontable.h"
+
+constexpr int TransitionTable::kBandSize;
+
+TransitionTable::TransitionTable()
+{
+}
+
+TransitionTable TransitionTable::build(const QImage& img)
+{
+    TransitionTable table;
+
+    if (img.isNull())
+    {
+        return table;
+    }
+
+    const auto& src = img.depth() == 32 ? img : img.convertToFormat(QImage::Format_RGB32);
+    const QRgb mask = src.hasAlphaChannel() ? 0xffffffff : 0x00ffffff;
+    const int w = src.width();
+    const int h = src.height();
+    const int stride = w + 1;
+
+    table.m_size = src.size();
+    table.m_horizontal.fill(0, stride * (h + 1));
+    table.m_vertical.fill(0, stride * (h + 1));
+
+    auto horizontal = table.m_horizontal.data();
+    auto vertical = table.m_vertical.data();
+
+    QVector<int> rows(h);
+    std::iota(rows.begin(), rows.end(), 0);
+
+    QtConcurrent::blockingMap(rows, [&](int y){
+        auto line = reinterpret_cast<const QRgb*>(src.constScanLine(y));
+        auto nextLine = y + 1 < h ? reinterpret_cast<const QRgb*>(src.constScanLine(y + 1)) : nullptr;
+        auto hOut = horizontal + (y + 1) * stride + 1;
+        auto vOut = vertical + (y + 1) * stride + 1;
+        quint32 hSum{0};
+        quint32 vSum{0};
+
+        for (int x = 0; x < w; ++x)
+        {
+            hSum += x + 1 < w && ((line[x] ^ line[x + 1]) & mask);
+            vSum += nextLine && ((line[x] ^ nextLine[x]) & mask);
+            hOut[x] = hSum;
+            vOut[x] = vSum;
+        }
+    });
+
+    prefixSum(horizontal, stride, h + 1);
+    prefixSum(vertical, stride, h + 1);
+
+    return table;
+}
+
+bool TransitionTable::isNull() const
+{
+    return m_size.isEmpty();
+}
+
+QSize TransitionTable::size() const
+{
+    return m_size;
+}
+
+quint32 TransitionTable::horizontalCount(const QRect& rect) const
+{
+    auto clipped = rect & QRect({0, 0}, m_size);
+
+    return clipped.isEmpty() ? 0 : sum(m_horizontal, clipped.left(), clipped.top(),
+                                       clipped.right() - 1, clipped.bottom());
+}
+
+quint32 TransitionTable::verticalCount(const QRect& rect) const
+{
+    auto clipped = rect & QRect({0, 0}, m_size);
+
+    return clipped.isEmpty() ? 0 : sum(m_vertical, clipped.left(), clipped.top(),
+                                       clipped.right(), clipped.bottom() - 1);
+}
+
+void TransitionTable::prefixSum(quint32* table, int width, int height)
+{
+    QVector<int> bands((width + kBandSize - 1) / kBandSize);
+    std::iota(bands.begin(), bands.end(), 0);
+
+    QtConcurrent::blockingMap(bands, [&](int band){
+        auto first = band * kBandSize;
+        auto last = qMin(first + kBandSize, width);
+
+        for (int y = 1; y < height; ++y)
+        {
+            auto line = table + y * width;
+            auto previous = line - width;
+
+            for (int x = first; x < last; ++x)
+            {
+                line[x] += previous[x];
+            }
+        }
+    });
+}
+
+quint32 TransitionTable::sum(const QVector<quint32>& table, int x1, int y1, int x2, int y2) const
+{
+    if (x2 < x1 || y2 < y1)
+    {
+        return 0;
+    }
+
+    auto stride = m_size.width() + 1;
+    auto data = table.constData();
+
+    return data[(y2 + 1) * stride + x2 + 1] - data[y1 * stride + x2 + 1] -
+           data[(y2 + 1) * stride + x1] + data[y1 * stride + x1];
+}
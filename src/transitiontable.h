@@ -0,0 +1,31 @@
+#ifndef TRANSITIONTABLE_H
+#define TRANSITIONTABLE_H
+
+#include <QImage>
+#include <QVector>
+
+class TransitionTable
+{
+public:
+    static constexpr int kBandSize{64};
+
+    TransitionTable();
+
+    static TransitionTable build(const QImage& img);
+
+    bool isNull() const;
+    QSize size() const;
+    quint32 horizontalCount(const QRect& rect) const;
+    quint32 verticalCount(const QRect& rect) const;
+
+private:
+    QSize m_size;
+    QVector<quint32> m_horizontal;
+    QVector<quint32> m_vertical;
+
+private:
+    static void prefixSum(quint32* table, int width, int height);
+    quint32 sum(const QVector<quint32>& table, int x1, int y1, int x2, int y2) const;
+};
+
+#endif // TRANSITIONTABLE_H
@@ -1,9 +1,15 @@
+#include <QCursor>
 #include <QMouseEvent>
+#include <QPainter>
+#include <QPixmapCache>
 #include <QScrollBar>
+#include <QtMath>
+#include <QtConcurrent>
 
 #include "view.h"
 #include "scene.h"
 #include "calculator.h"
+#include "profiler.h"
 
 View::View(QWidget* parent)
     : QGraphicsView(parent)
@@ -11,15 +17,115 @@ View::View(QWidget* parent)
     setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
     setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
     setMouseTracking(true);
+    setViewportUpdateMode(QGraphicsView::MinimalViewportUpdate);
 
     m_scene = new Scene(this);
     m_scene->setPalette(m_palettes[m_paletteIndex]);
     connect(m_scene, &Scene::fixedRectanglChanged, this, &View::correctFixedRectangle);
 
+    connect(&m_edgeMapWatcher, &QFutureWatcher<EdgeMap>::finished, this, [this](){
+        if (m_edgeMapWatcher.future().resultCount() == 0)
+        {
+            return;
+        }
+
+        auto edgeMap = m_edgeMapWatcher.result();
+
+        if (edgeMap.size() == m_renderData.screenImage.size())
+        {
+            m_edgeMap = edgeMap;
+        }
+    });
+
+    connect(&m_diffMapWatcher, &QFutureWatcher<DiffMap>::finished, this, [this](){
+        if (m_diffMapWatcher.future().resultCount() == 0)
+        {
+            return;
+        }
+
+        m_diffMap = m_diffMapWatcher.result();
+        m_renderData.diffImage = m_diffMap.image();
+        updateScene();
+    });
+
+    connect(&m_clearanceMapWatcher, &QFutureWatcher<ClearanceMap>::finished, this, [this](){
+        if (m_clearanceMapWatcher.future().resultCount() == 0)
+        {
+            return;
+        }
+
+        m_clearanceMap = m_clearanceMapWatcher.result();
+        m_renderData.clearanceImage = m_clearanceMap.heatmap;
+        ++m_clearanceGeneration;
+        updateScene();
+    });
+
+    connect(&m_transitionTableWatcher, &QFutureWatcher<TransitionTable>::finished, this, [this](){
+        if (m_transitionTableWatcher.future().resultCount() == 0)
+        {
+            return;
+        }
+
+        m_transitionTable = m_transitionTableWatcher.result();
+        ++m_transitionGeneration;
+        updateScene();
+    });
+
+    connect(&m_alignmentMapWatcher, &QFutureWatcher<AlignmentMap>::finished, this, [this](){
+        if (m_alignmentMapWatcher.future().resultCount() == 0)
+        {
+            return;
+        }
+
+        m_alignmentMap = m_alignmentMapWatcher.result();
+        ++m_alignmentGeneration;
+        updateScene();
+    });
+
+    connect(&m_colorStatsWatcher, &QFutureWatcher<ColorStats>::finished, this, [this](){
+        if (m_colorStatsWatcher.future().resultCount() == 0)
+        {
+            return;
+        }
+
+        m_colorStats = m_colorStatsWatcher.result();
+
+        if (m_colorStats.matches(m_renderData.screenImage, colorStatsRectangle()))
+        {
+            m_renderData.colorStats = m_colorStats;
+            emit renderDataChanged(m_renderData);
+        }
+
+        buildColorStats();
+    });
+
+    m_colorStatsTimer = new QTimer(this);
+    m_colorStatsTimer->setSingleShot(true);
+    m_colorStatsTimer->setInterval(kColorStatsDelay);
+    connect(m_colorStatsTimer, &QTimer::timeout, this, &View::buildColorStats);
+
+    m_containers.reserve(int(Calculator::kMaxContainerDepth));
+    m_renderData.alignmentLines.reserve(kAlignmentLineCapacity);
+
     setScene(m_scene);
     updateScene();
 }
 
+qint64 View::updateCount() const
+{
+    return m_updateCount;
+}
+
+qint64 View::calculationAllocationCount() const
+{
+    return m_calculationAllocations;
+}
+
+qint64 View::sceneAllocationCount() const
+{
+    return m_sceneAllocations;
+}
+
 void View::mousePressEvent(QMouseEvent* event)
 {
     m_renderData.isItemDragging =
@@ -83,6 +189,18 @@ void View::wheelEvent(QWheelEvent* event)
     QPoint numPixels = event->pixelDelta();
     QPoint numDegrees = event->angleDelta() / 8;
 
+    if (event->modifiers() & Qt::ControlModifier)
+    {
+        auto delta = numPixels.isNull() ? numDegrees : numPixels;
+
+        if (delta.y() != 0)
+        {
+            walkContainers(delta.y() > 0 ? 1 : -1);
+        }
+
+        return;
+    }
+
     if (!numPixels.isNull())
     {
         changeScale(numPixels);
@@ -109,11 +227,25 @@ void View::wheelEvent(QWheelEvent* event)
 
 void View::updateScene()
 {
+    auto allocations = Profiler::heapAllocationCount();
+
     calculate();
+
+    m_calculationAllocations = Profiler::heapAllocationCount() - allocations;
+    allocations = Profiler::heapAllocationCount();
+
     m_scene->setRenderData(m_renderData);
-    update();
 
     emit renderDataChanged(m_renderData);
+
+    m_sceneAllocations = Profiler::heapAllocationCount() - allocations;
+    ++m_updateCount;
+
+    if (!m_colorStatsTimer->isActive() &&
+        !m_colorStats.matches(m_renderData.screenImage, colorStatsRectangle()))
+    {
+        m_colorStatsTimer->start();
+    }
 }
 
 void View::setFixedRectangle()
@@ -137,18 +269,7 @@ void View::calculate()
 {
     if (m_renderData.isCursorRectPresent)
     {
-        const auto& img = m_renderData.screenImage.toImage();
-
-        m_renderData.cursorColor =
-                Calculator::calculateCursorColor(m_renderData.cursorPoint, img);
-
-        m_renderData.cursorRectangle =
-                Calculator::calculateCursorRectangle(m_renderData.cursorPoint, img);
-
-        auto lines = Calculator::calculateCursorLines(m_renderData.cursorPoint,
-                                                      m_renderData.cursorRectangle);
-        m_renderData.cursorHLine = lines[0];
-        m_renderData.cursorVLine = lines[1];
+        calculateCursor();
     }
     else
     {
@@ -156,17 +277,22 @@ void View::calculate()
         m_renderData.cursorHLine = {kPoint, kPoint};
         m_renderData.cursorVLine = {kPoint, kPoint};
         m_renderData.cursorRectangle = {kPoint, kPoint};
+        m_renderData.isSubpixelPresent = false;
+        m_cursorRectStage.invalidate();
+        m_referenceStage.invalidate();
+        m_clearanceStage.invalidate();
+        m_cursorLinesStage.invalidate();
     }
 
-    if (m_renderData.isFixedRectPresent && m_renderData.isCursorRectPresent)
+    if (!m_containerStage.isCurrent(m_renderData.cursorRectangle, m_imageGeneration, m_containerLevel,
+                                    m_renderData.isTextPresent, m_renderData.isCursorRectPresent))
     {
-        m_renderData.fixedLines = Calculator::calculateFixedLines(m_renderData.fixedRectangle,
-                                                                  m_renderData.screenImage.toImage());
-        auto lines = Calculator::calculateMeasureLines(m_renderData.cursorRectangle,
-                                                       m_renderData.fixedRectangle);
+        calculateContainer();
+    }
 
-        m_renderData.measureVLine = lines[0];
-        m_renderData.measureHLine = lines[1];
+    if (m_renderData.isFixedRectPresent && m_renderData.isCursorRectPresent)
+    {
+        calculateFixed();
     }
     else
     {
@@ -177,9 +303,176 @@ void View::calculate()
         m_renderData.fixedLines[3] = {kPoint, kPoint};
         m_renderData.measureVLine = {kPoint, kPoint};
         m_renderData.measureHLine = {kPoint, kPoint};
+        m_renderData.alignmentLines.clear();
+        m_renderData.fixedRectTransitions = -1;
+        m_fixedLinesStage.invalidate();
+        m_measureLinesStage.invalidate();
+    }
+
+    // Not a stage: matching the finished statistics is a rect and cache key comparison.
+    m_renderData.colorStats = m_colorStats.matches(m_renderData.screenImage, colorStatsRectangle())
+            ? m_colorStats
+            : ColorStats{};
+}
+
+void View::calculateCursor()
+{
+    const auto& img = m_renderData.screenImage;
+    const auto& tiledImg = m_renderData.tiledImage;
+    const auto& pos = m_renderData.cursorPoint;
+
+    if (!m_cursorColorStage.isCurrent(pos, m_imageGeneration))
+    {
+        m_renderData.cursorColor = tiledImg.isNull()
+                ? Calculator::calculateCursorColor(pos, img)
+                : Calculator::calculateCursorColor(pos, tiledImg);
+    }
+
+    if (!m_cursorRectStage.isCurrent(pos, m_imageGeneration,
+                                     m_renderData.isTextMode, m_renderData.isSubpixelMode))
+    {
+        if (!tiledImg.isNull())
+        {
+            m_renderData.cursorRectangle = Calculator::calculateCursorRectangle(pos, tiledImg, m_cursorRun);
+        }
+        else
+        {
+            m_renderData.cursorRectangle = m_edgeMap.size() == img.size()
+                    ? Calculator::calculateCursorRectangle(pos, m_edgeMap, m_cursorRun)
+                    : Calculator::calculateCursorRectangle(pos, img, m_cursorRun);
+        }
+
+        auto textRun = m_renderData.isTextMode && tiledImg.isNull()
+                ? Calculator::calculateTextRun(pos, img)
+                : TextRun{};
+
+        m_renderData.isTextPresent = textRun.isValid;
+
+        if (textRun.isValid)
+        {
+            const auto& rect = textRun.rect;
+            m_renderData.cursorRectangle = rect;
+            m_renderData.baselineLine = {rect.x(), textRun.baseline,
+                                         rect.x() + rect.width() + 1, textRun.baseline};
+        }
+
+        m_renderData.isSubpixelPresent = m_renderData.isSubpixelMode && !textRun.isValid && tiledImg.isNull();
+
+        if (m_renderData.isSubpixelPresent)
+        {
+            m_renderData.subpixelRectangle = Calculator::calculateSubpixelRectangle(
+                        pos, m_renderData.cursorRectangle, img);
+        }
+    }
+
+    if (!m_referenceStage.isCurrent(pos, m_referenceGeneration, m_renderData.isReferencePresent))
+    {
+        m_renderData.referenceRectangle = m_renderData.isReferencePresent
+                ? Calculator::calculateCursorRectangle(pos, m_renderData.referenceImage, m_referenceRun)
+                : QRect{};
+    }
+
+    if (!m_clearanceStage.isCurrent(pos, m_clearanceGeneration, m_renderData.isClearancePresent))
+    {
+        m_renderData.clearanceLine = m_renderData.isClearancePresent
+                ? Calculator::calculateClearanceLine(pos, m_clearanceMap)
+                : QLine{};
+
+        m_renderData.clearance = QLineF(m_renderData.clearanceLine).length();
+    }
+
+    if (!m_cursorLinesStage.isCurrent(pos, m_renderData.cursorRectangle))
+    {
+        auto lines = Calculator::calculateCursorLines(pos, m_renderData.cursorRectangle);
+        m_renderData.cursorHLine = lines[0];
+        m_renderData.cursorVLine = lines[1];
     }
 }
 
+void View::calculateFixed()
+{
+    const auto& fixedRect = m_renderData.fixedRectangle;
+
+    if (!m_fixedLinesStage.isCurrent(fixedRect, m_imageGeneration, m_transitionGeneration, m_alignmentGeneration,
+                                     m_renderData.isAlignmentPresent, m_renderData.alignmentTolerance))
+    {
+        auto size = m_renderData.tiledImage.isNull() ? m_renderData.screenImage.size()
+                                                     : m_renderData.tiledImage.size();
+
+        m_renderData.fixedLines = Calculator::calculateFixedLines(fixedRect, size);
+
+        m_renderData.fixedRectTransitions = m_transitionTable.size() == m_renderData.screenImage.size()
+                ? int(Calculator::calculateTransitionCount(fixedRect, m_transitionTable))
+                : -1;
+
+        if (m_renderData.isAlignmentPresent && m_alignmentMap.size() == m_renderData.screenImage.size())
+        {
+            m_alignmentMap.alignedEdges(fixedRect, m_renderData.alignmentTolerance,
+                                        m_renderData.alignmentLines);
+        }
+        else
+        {
+            m_renderData.alignmentLines.clear();
+        }
+    }
+
+    if (!m_measureLinesStage.isCurrent(m_renderData.cursorRectangle, fixedRect))
+    {
+        auto lines = Calculator::calculateMeasureLines(m_renderData.cursorRectangle, fixedRect);
+
+        m_renderData.measureVLine = lines[0];
+        m_renderData.measureHLine = lines[1];
+    }
+}
+
+std::array<StageCounters, 8> View::stageCounters() const
+{
+    return {{
+        m_cursorColorStage.counters(),
+        m_cursorRectStage.counters(),
+        m_referenceStage.counters(),
+        m_clearanceStage.counters(),
+        m_cursorLinesStage.counters(),
+        m_containerStage.counters(),
+        m_fixedLinesStage.counters(),
+        m_measureLinesStage.counters()
+    }};
+}
+
+void View::calculateContainer()
+{
+    if (m_renderData.cursorRectangle != m_containerBase)
+    {
+        m_containerBase = m_renderData.cursorRectangle;
+        m_containerLevel = 0;
+    }
+
+    auto level = m_renderData.isTextPresent ? qMax(1, m_containerLevel) : m_containerLevel;
+
+    m_containers.clear();
+
+    if (level > 0 && m_renderData.isCursorRectPresent && m_renderData.tiledImage.isNull())
+    {
+        Calculator::calculateContainers(m_containerBase, m_renderData.screenImage,
+                                        m_containerTree, level, m_containers);
+    }
+    else if (level > 0 && m_renderData.isCursorRectPresent)
+    {
+        Calculator::calculateContainers(m_containerBase, m_renderData.tiledImage,
+                                        m_containerTree, level, m_containers);
+    }
+
+    level = qMin(level, m_containers.size());
+    m_containerLevel = qMin(m_containerLevel, level);
+    m_renderData.containerLevel = level;
+    m_renderData.isContainerPresent = level > 0;
+    m_renderData.containerRectangle = m_renderData.isContainerPresent
+            ? m_containers[level - 1]
+            : QRect{kPoint, kPoint};
+    m_renderData.insetLines = Calculator::calculateInsetLines(m_renderData.cursorRectangle,
+                                                              m_renderData.containerRectangle);
+}
+
 int View::beamTo(int startPos, int endPos, int coord, int step,
                        Qt::Orientation orientation, const QRgb& color)
 {
@@ -194,7 +487,7 @@ int View::beamTo(int startPos, int endPos, int coord, int step,
             break;
         }
 
-        if (m_renderData.screenImage.toImage().pixel(point) != color)
+        if (m_renderData.screenImage.pixel(point) != color)
         {
             return pos - step;
         }
@@ -224,6 +517,8 @@ void View::switchPalette()
         m_paletteIndex = 0;
     }
     m_scene->setPalette(m_palettes[m_paletteIndex]);
+    buildDiffMap();
+    viewport()->update();
 }
 
 void View::shiftScene(int dx, int dy)
@@ -238,12 +533,418 @@ void View::shiftScene(int dx, int dy)
 
 void View::setPixmap(const QPixmap& pixmap)
 {
-    m_renderData.screenImage = pixmap;
+    setImage(pixmap.toImage());
+}
+
+void View::setImage(const QImage& image)
+{
+    m_renderData.screenImage = Calculator::toPixelViewImage(image);
+    m_renderData.tiledImage = {};
+    m_cursorRun = {};
+    ++m_imageGeneration;
+    m_containerTree = {};
+    buildEdgeMap();
+    buildTransitionTable();
+    buildDiffMap();
+    buildClearanceMap();
+    buildAlignmentMap();
+    updateScene();
+}
+
+void View::setTiledImage(const TiledImage& image)
+{
+    m_renderData.screenImage = {};
+    m_renderData.tiledImage = image;
+    m_cursorRun = {};
+    ++m_imageGeneration;
+    m_containerTree = {};
+    m_renderData.isFixedRectPresent = false;
+    buildEdgeMap();
+    buildTransitionTable();
+    buildDiffMap();
+    buildClearanceMap();
+    buildAlignmentMap();
+    updateScene();
+}
+
+void View::restoreSession(const RenderData& renderData, const EdgeMap& edgeMap)
+{
+    m_renderData.screenImage = Calculator::toPixelViewImage(renderData.screenImage);
+    m_renderData.tiledImage = {};
+    m_cursorRun = {};
+    ++m_imageGeneration;
+    m_containerTree = {};
+    m_renderData.cursorPoint = renderData.cursorPoint;
+    m_renderData.fixedRectangle = renderData.fixedRectangle;
+    m_renderData.isFixedRectPresent = renderData.isFixedRectPresent;
+    m_renderData.isCursorRectPresent = true;
+
+    if (edgeMap.size() == renderData.screenImage.size())
+    {
+        m_edgeMapWatcher.setFuture({});
+        m_edgeMap = edgeMap;
+    }
+    else
+    {
+        buildEdgeMap();
+    }
+
+    buildTransitionTable();
+    buildDiffMap();
+    buildClearanceMap();
+    buildAlignmentMap();
+    updateScene();
+}
+
+const Palette& View::palette() const
+{
+    return m_palettes[m_paletteIndex];
+}
+
+const RenderData& View::renderData() const
+{
+    return m_renderData;
+}
+
+const EdgeMap& View::edgeMap() const
+{
+    return m_edgeMap;
+}
+
+void View::setReferenceImage(const QImage& image)
+{
+    m_renderData.referenceImage = Calculator::toPixelViewImage(image);
+    m_renderData.isReferencePresent = !image.isNull();
+    m_referenceRun = {};
+    ++m_referenceGeneration;
+    buildDiffMap();
+    updateScene();
+}
+
+void View::clearReferenceImage()
+{
+    setReferenceImage({});
+}
+
+void View::jumpToNextDifference()
+{
+    auto rect = m_diffMap.nextDifference(m_renderData.cursorPoint);
+
+    if (rect.isEmpty())
+    {
+        return;
+    }
+
+    m_renderData.cursorPoint = rect.center();
+    m_renderData.isCursorRectPresent = true;
+    centerOn(rect.center());
+    updateScene();
+}
+
+void View::switchClearance()
+{
+    m_renderData.isClearancePresent = !m_renderData.isClearancePresent;
+    buildClearanceMap();
+    updateScene();
+}
+
+void View::nudgeCursor(int dx, int dy)
+{
+    m_renderData.cursorPoint += QPoint(dx, dy);
+    m_renderData.isCursorRectPresent = true;
+    QCursor::setPos(viewport()->mapToGlobal(
+                        mapFromScene(QPointF(m_renderData.cursorPoint) + QPointF(0.5, 0.5))));
+    updateScene();
+}
+
+void View::walkContainers(int step)
+{
+    m_containerLevel = qBound(0, m_containerLevel + step, int(Calculator::kMaxContainerDepth));
+    updateScene();
+}
+
+void View::switchTextMode()
+{
+    m_renderData.isTextMode = !m_renderData.isTextMode;
+    updateScene();
+}
+
+void View::switchSubpixelMode()
+{
+    m_renderData.isSubpixelMode = !m_renderData.isSubpixelMode;
     updateScene();
 }
 
+void View::switchAlignment()
+{
+    if (!m_renderData.isAlignmentPresent)
+    {
+        m_renderData.isAlignmentPresent = true;
+        m_renderData.alignmentTolerance = 0;
+    }
+    else if (m_renderData.alignmentTolerance == 0)
+    {
+        m_renderData.alignmentTolerance = kAlignmentTolerance;
+    }
+    else
+    {
+        m_renderData.isAlignmentPresent = false;
+    }
+
+    if (m_alignmentMap.size() != m_renderData.screenImage.size())
+    {
+        buildAlignmentMap();
+    }
+
+    updateScene();
+}
+
+void View::switchGrid()
+{
+    m_isGridVisible = !m_isGridVisible;
+    viewport()->update();
+}
+
+void View::drawForeground(QPainter* painter, const QRectF& rect)
+{
+    QGraphicsView::drawForeground(painter, rect);
+
+    if (m_scale <= kMinScale)
+    {
+        return;
+    }
+
+    updateOverlayCache();
+
+    const auto& palette = m_palettes[m_paletteIndex];
+    auto origin = mapFromScene(QPointF(0, 0));
+    auto size = viewport()->size();
+    auto exposed = mapFromScene(rect).boundingRect().adjusted(-1, -1, 1, 1) & viewport()->rect();
+    QRect horizontalRuler{0, 0, size.width(), kRulerSize};
+    QRect verticalRuler{0, 0, kRulerSize, size.height()};
+
+    painter->save();
+    painter->resetTransform();
+
+    if (m_isGridVisible && !m_gridTile.isNull())
+    {
+        auto gridRect = mapFromScene(sceneRect()).boundingRect() & exposed;
+        auto period = m_gridTile.width();
+
+        painter->drawTiledPixmap(gridRect, m_gridTile,
+                                 {((gridRect.x() - origin.x()) % period + period) % period,
+                                  ((gridRect.y() - origin.y()) % period + period) % period});
+    }
+
+    if (exposed.intersects(horizontalRuler) || exposed.intersects(verticalRuler))
+    {
+        auto period = m_horizontalRulerTile.width();
+        auto offset = QPoint{(-origin.x() % period + period) % period,
+                             (-origin.y() % period + period) % period};
+
+        painter->drawTiledPixmap(horizontalRuler, m_horizontalRulerTile, {offset.x(), 0});
+        painter->drawTiledPixmap(verticalRuler, m_verticalRulerTile, {0, offset.y()});
+        painter->fillRect(QRect(0, 0, kRulerSize, kRulerSize), palette.background);
+
+        drawRulerLabels(painter, origin);
+    }
+
+    painter->restore();
+}
+
+void View::resizeEvent(QResizeEvent* event)
+{
+    QGraphicsView::resizeEvent(event);
+
+    auto ratio = viewport()->devicePixelRatioF();
+    auto bytes = qint64(viewport()->width() * ratio) * qint64(viewport()->height() * ratio) * 4;
+
+    QPixmapCache::setCacheLimit(qMax(QPixmapCache::cacheLimit(),
+                                     int(bytes * kBackingStoreCount / 1024)));
+}
+
+void View::scrollContentsBy(int dx, int dy)
+{
+    QGraphicsView::scrollContentsBy(dx, dy);
+
+    if (m_scale > kMinScale)
+    {
+        viewport()->update(QRect(0, 0, viewport()->width(), kRulerSize + qAbs(dy)));
+        viewport()->update(QRect(0, 0, kRulerSize + qAbs(dx), viewport()->height()));
+    }
+}
+
+void View::updateOverlayCache()
+{
+    if (m_overlayScale == m_scale && m_overlayPaletteIndex == m_paletteIndex)
+    {
+        return;
+    }
+
+    m_overlayScale = m_scale;
+    m_overlayPaletteIndex = m_paletteIndex;
+
+    const auto& palette = m_palettes[m_paletteIndex];
+    auto period = kRulerMajorStep * m_scale;
+
+    m_horizontalRulerTile = QPixmap(period, kRulerSize);
+    m_verticalRulerTile = QPixmap(kRulerSize, period);
+    m_horizontalRulerTile.fill(palette.background);
+    m_verticalRulerTile.fill(palette.background);
+
+    QPainter horizontalPainter(&m_horizontalRulerTile);
+    QPainter verticalPainter(&m_verticalRulerTile);
+    horizontalPainter.setPen(palette.cursorRectangle);
+    verticalPainter.setPen(palette.cursorRectangle);
+
+    for (int i = 0; i < kRulerMajorStep; ++i)
+    {
+        auto isMajor = i == 0;
+        auto isMiddle = i == kRulerMajorStep / 2;
+
+        if (!isMajor && !isMiddle && m_scale < kRulerMinorScale)
+        {
+            continue;
+        }
+
+        auto length = isMajor ? kRulerSize : isMiddle ? kRulerSize / 2 : kRulerSize / 4;
+        auto pos = i * m_scale;
+
+        horizontalPainter.drawLine(pos, 0, pos, length - 1);
+        verticalPainter.drawLine(0, pos, length - 1, pos);
+    }
+
+    m_gridTile = {};
+
+    if (m_scale >= kGridMinScale)
+    {
+        auto gridColor = palette.background;
+        gridColor.setAlpha(0x80);
+
+        m_gridTile = QPixmap(period, period);
+        m_gridTile.fill(Qt::transparent);
+
+        QPainter gridPainter(&m_gridTile);
+        gridPainter.setPen(gridColor);
+
+        for (int pos = 0; pos < period; pos += m_scale)
+        {
+            gridPainter.drawLine(pos, 0, pos, period - 1);
+            gridPainter.drawLine(0, pos, period - 1, pos);
+        }
+    }
+}
+
+void View::drawRulerLabels(QPainter* painter, const QPoint& origin)
+{
+    auto period = kRulerMajorStep * m_scale;
+    auto step = kRulerMajorStep * ((kRulerLabelSpacing + period - 1) / period);
+    auto size = viewport()->size();
+    auto font = painter->font();
+    font.setPixelSize(kRulerSize / 2);
+
+    painter->setFont(font);
+    painter->setPen(m_palettes[m_paletteIndex].cursorRectangle);
+
+    for (auto x = qFloor(-origin.x() / double(step * m_scale)) * step;
+         origin.x() + x * m_scale < size.width(); x += step)
+    {
+        painter->drawText(origin.x() + x * m_scale + 2, kRulerSize - 2, QString::number(x));
+    }
+
+    for (auto y = qFloor(-origin.y() / double(step * m_scale)) * step;
+         origin.y() + y * m_scale < size.height(); y += step)
+    {
+        painter->save();
+        painter->translate(kRulerSize / 2, origin.y() + y * m_scale + 2);
+        painter->rotate(90);
+        painter->drawText(0, 0, QString::number(y));
+        painter->restore();
+    }
+}
+
+void View::buildColorStats()
+{
+    const auto& img = m_renderData.screenImage;
+
+    if (img.isNull() || m_colorStatsWatcher.isRunning() || m_renderData.isItemDragging ||
+        m_colorStats.matches(img, colorStatsRectangle()))
+    {
+        return;
+    }
+
+    m_colorStatsWatcher.setFuture(QtConcurrent::run(&ColorStats::calculate, img, colorStatsRectangle()));
+}
+
+QRect View::colorStatsRectangle() const
+{
+    return m_renderData.isFixedRectPresent ? m_renderData.fixedRectangle
+                                           : m_renderData.cursorRectangle;
+}
+
+void View::buildEdgeMap()
+{
+    m_edgeMap = {};
+    m_edgeMapWatcher.setFuture(QtConcurrent::run(&EdgeMap::build, m_renderData.screenImage));
+}
+
 void View::clearFixedRect()
 {
     m_renderData.isFixedRectPresent = false;
     updateScene();
 }
+
+void View::buildDiffMap()
+{
+    m_diffMap = {};
+    m_renderData.diffImage = {};
+
+    if (!m_renderData.isReferencePresent || m_renderData.screenImage.isNull())
+    {
+        m_diffMapWatcher.setFuture({});
+        return;
+    }
+
+    m_diffMapWatcher.setFuture(QtConcurrent::run(&DiffMap::build,
+                                                 m_renderData.screenImage,
+                                                 m_renderData.referenceImage,
+                                                 kDiffTolerance,
+                                                 m_palettes[m_paletteIndex].difference.rgb()));
+}
+
+void View::buildClearanceMap()
+{
+    m_clearanceMap = {};
+    m_renderData.clearanceImage = {};
+    ++m_clearanceGeneration;
+
+    if (!m_renderData.isClearancePresent || m_renderData.screenImage.isNull())
+    {
+        m_clearanceMapWatcher.setFuture({});
+        return;
+    }
+
+    m_clearanceMapWatcher.setFuture(QtConcurrent::run(&Calculator::calculateClearanceMap,
+                                                      m_renderData.screenImage));
+}
+
+void View::buildAlignmentMap()
+{
+    m_alignmentMap = {};
+    ++m_alignmentGeneration;
+
+    if (!m_renderData.isAlignmentPresent || m_renderData.screenImage.isNull())
+    {
+        m_alignmentMapWatcher.setFuture({});
+        return;
+    }
+
+    m_alignmentMapWatcher.setFuture(QtConcurrent::run(&AlignmentMap::build, m_renderData.screenImage));
+}
+
+void View::buildTransitionTable()
+{
+    m_transitionTable = {};
+    ++m_transitionGeneration;
+    m_transitionTableWatcher.setFuture(QtConcurrent::run(&TransitionTable::build, m_renderData.screenImage));
+}
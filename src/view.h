@@ -2,7 +2,15 @@
 #define VIEW_H
 
 #include <QGraphicsView>
+#include <QFutureWatcher>
+#include <QTimer>
+
 #include "scene.h"
+#include "edgemap.h"
+#include "diffmap.h"
+#include "alignmentmap.h"
+#include "calculator.h"
+#include "calculationstage.h"
 
 class View : public QGraphicsView
 {
@@ -11,6 +19,16 @@ class View : public QGraphicsView
     const QPoint kPoint{1,1};
     const int kMinScale{1};
     const int kMaxScale{8};
+    const int kDiffTolerance{4};
+    const int kAlignmentTolerance{2};
+    const int kRulerSize{18};
+    const int kRulerMajorStep{10};
+    const int kRulerMinorScale{3};
+    const int kGridMinScale{4};
+    const int kRulerLabelSpacing{40};
+    const int kBackingStoreCount{2};
+    const int kAlignmentLineCapacity{256};
+    const int kColorStatsDelay{100};
 
     const Palette kDarkPalette {
         QColor{0x333333},           //background
@@ -19,6 +37,7 @@ class View : public QGraphicsView
         Qt::cyan,                   //cursorRectangle;
         Qt::darkCyan,               //cursorLines;
         Qt::yellow,                 //measurerLines;
+        QColor{0xff5050},           //difference;
     };
 
     const Palette kLightPalette {
@@ -28,6 +47,7 @@ class View : public QGraphicsView
         Qt::darkBlue,
         Qt::blue,
         Qt::red,
+        QColor{0xff8000},
     };
 
 public:
@@ -36,7 +56,28 @@ public:
     void switchPalette();
     void shiftScene(int dx, int dy);
     void setPixmap(const QPixmap& pixmap);
+    void setImage(const QImage& image);
+    void setTiledImage(const TiledImage& image);
+    void restoreSession(const RenderData& renderData, const EdgeMap& edgeMap);
     void clearFixedRect();
+    void setReferenceImage(const QImage& image);
+    void clearReferenceImage();
+    void jumpToNextDifference();
+    void switchClearance();
+    void switchGrid();
+    void nudgeCursor(int dx, int dy);
+    void walkContainers(int step);
+    void switchTextMode();
+    void switchSubpixelMode();
+    void switchAlignment();
+
+    const RenderData& renderData() const;
+    const Palette& palette() const;
+    const EdgeMap& edgeMap() const;
+    qint64 updateCount() const;
+    qint64 calculationAllocationCount() const;
+    qint64 sceneAllocationCount() const;
+    std::array<StageCounters, 8> stageCounters() const;
 
 signals:
     void renderDataChanged(const RenderData& renderData);
@@ -46,14 +87,58 @@ protected:
     void mouseReleaseEvent(QMouseEvent* event) override;
     void mouseMoveEvent(QMouseEvent* event) override;
     void wheelEvent(QWheelEvent* event) override;
+    void drawForeground(QPainter* painter, const QRectF& rect) override;
+    void scrollContentsBy(int dx, int dy) override;
+    void resizeEvent(QResizeEvent* event) override;
 
 private:
     Scene* m_scene;
     RenderData m_renderData;
+    EdgeMap m_edgeMap;
+    QFutureWatcher<EdgeMap> m_edgeMapWatcher;
+    DiffMap m_diffMap;
+    QFutureWatcher<DiffMap> m_diffMapWatcher;
+    ClearanceMap m_clearanceMap;
+    CursorRun m_cursorRun;
+    CursorRun m_referenceRun;
+    ContainerTree m_containerTree;
+    QRect m_containerBase;
+    int m_containerLevel{0};
+    QVector<QRect> m_containers;
+    ColorStats m_colorStats;
+    QFutureWatcher<ColorStats> m_colorStatsWatcher;
+    QTimer* m_colorStatsTimer;
+    QFutureWatcher<ClearanceMap> m_clearanceMapWatcher;
+    TransitionTable m_transitionTable;
+    QFutureWatcher<TransitionTable> m_transitionTableWatcher;
+    AlignmentMap m_alignmentMap;
+    QFutureWatcher<AlignmentMap> m_alignmentMapWatcher;
     QPoint m_lastMousePos;
     QVector<Palette> m_palettes{kDarkPalette, kLightPalette};
     int m_scale{kMinScale};
     int m_paletteIndex{0};
+    QPixmap m_horizontalRulerTile;
+    QPixmap m_verticalRulerTile;
+    QPixmap m_gridTile;
+    int m_overlayScale{0};
+    int m_overlayPaletteIndex{-1};
+    bool m_isGridVisible{false};
+    qint64 m_updateCount{0};
+    qint64 m_calculationAllocations{0};
+    qint64 m_sceneAllocations{0};
+    quint64 m_imageGeneration{0};
+    quint64 m_referenceGeneration{0};
+    quint64 m_clearanceGeneration{0};
+    quint64 m_transitionGeneration{0};
+    quint64 m_alignmentGeneration{0};
+    CalculationStage<QPoint, quint64> m_cursorColorStage{"cursor color"};
+    CalculationStage<QPoint, quint64, bool, bool> m_cursorRectStage{"cursor rect"};
+    CalculationStage<QPoint, quint64, bool> m_referenceStage{"reference rect"};
+    CalculationStage<QPoint, quint64, bool> m_clearanceStage{"clearance line"};
+    CalculationStage<QPoint, QRect> m_cursorLinesStage{"cursor lines"};
+    CalculationStage<QRect, quint64, int, bool, bool> m_containerStage{"containers"};
+    CalculationStage<QRect, quint64, quint64, quint64, bool, int> m_fixedLinesStage{"fixed lines"};
+    CalculationStage<QRect, QRect> m_measureLinesStage{"measure lines"};
 
 private:
     void updateScene();
@@ -61,6 +146,18 @@ private:
     void correctFixedRectangle(const QRect& rect);
     void changeScale(const QPoint& delta);
     void calculate();
+    void calculateCursor();
+    void calculateFixed();
+    void calculateContainer();
+    void buildEdgeMap();
+    void buildDiffMap();
+    void buildClearanceMap();
+    void buildAlignmentMap();
+    void buildTransitionTable();
+    void buildColorStats();
+    QRect colorStatsRectangle() const;
+    void updateOverlayCache();
+    void drawRulerLabels(QPainter* painter, const QPoint& origin);
     int beamTo(int startPos, int endPos, int coord, int step,
                Qt::Orientation orientation, const QRgb& color);
 };
@@ -1,12 +1,21 @@
-#include <QDesktopWidget>
-#include <QScreen>
 #include <QApplication>
 #include <QShortcut>
 #include <QVBoxLayout>
 #include <QTimer>
+#include <QTextStream>
+#include <QFileDialog>
+#include <QtConcurrent>
+#include <QDebug>
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
 
 #include "window.h"
 #include "view.h"
+#include "session.h"
+#include "redline.h"
+#include "profiler.h"
+#include "bufferpool.h"
 
 Window::Window(QWidget* parent) :
     QMainWindow(parent)
@@ -20,6 +29,8 @@ Window::Window(QWidget* parent) :
     setAttribute(Qt::WA_TranslucentBackground);
     setMouseTracking(true);
     setWindowTitle(kTitle);
+    m_title.reserve(kTitleCapacity);
+    m_shownTitle.reserve(kTitleCapacity);
 #ifdef Q_OS_WIN
     setWindowOpacity(0.1);
 #endif
@@ -47,18 +58,135 @@ void Window::initialize()
     auto clearShortcut = new QShortcut(QKeySequence(Qt::Key_Space), this);
     connect(clearShortcut, &QShortcut::activated, m_view, &View::clearFixedRect);
 
-    QTimer::singleShot(0,[&](){
-        grabScreen();
-    });
+    auto saveShortcut = new QShortcut(QKeySequence::Save, this);
+    connect(saveShortcut, &QShortcut::activated, this, &Window::saveSession);
+
+    auto openShortcut = new QShortcut(QKeySequence::Open, this);
+    connect(openShortcut, &QShortcut::activated, this, &Window::openFile);
+
+    connect(&m_imageWatcher, &QFutureWatcher<TiledImage>::finished, this, &Window::onImageLoaded);
+
+    auto exportShortcut = new QShortcut(QKeySequence(Qt::CTRL + Qt::Key_E), this);
+    connect(exportShortcut, &QShortcut::activated, this, &Window::exportRedline);
+    connect(&m_exportWatcher, &QFutureWatcher<bool>::finished, this, &Window::onRedlineExported);
+
+    auto referenceShortcut = new QShortcut(QKeySequence(Qt::CTRL + Qt::Key_R), this);
+    connect(referenceShortcut, &QShortcut::activated, this, &Window::toggleReferenceImage);
+
+    auto differenceShortcut = new QShortcut(QKeySequence(Qt::Key_N), this);
+    connect(differenceShortcut, &QShortcut::activated, m_view, &View::jumpToNextDifference);
+
+    auto clearanceShortcut = new QShortcut(QKeySequence(Qt::Key_H), this);
+    connect(clearanceShortcut, &QShortcut::activated, m_view, &View::switchClearance);
+
+    auto gridShortcut = new QShortcut(QKeySequence(Qt::Key_G), this);
+    connect(gridShortcut, &QShortcut::activated, m_view, &View::switchGrid);
+
+    auto textShortcut = new QShortcut(QKeySequence(Qt::Key_T), this);
+    connect(textShortcut, &QShortcut::activated, m_view, &View::switchTextMode);
+
+    auto subpixelShortcut = new QShortcut(QKeySequence(Qt::Key_S), this);
+    connect(subpixelShortcut, &QShortcut::activated, m_view, &View::switchSubpixelMode);
+
+    auto alignmentShortcut = new QShortcut(QKeySequence(Qt::Key_A), this);
+    connect(alignmentShortcut, &QShortcut::activated, m_view, &View::switchAlignment);
+
+    auto leftShortcut = new QShortcut(QKeySequence(Qt::Key_Left), this);
+    connect(leftShortcut, &QShortcut::activated, m_view, [this](){ m_view->nudgeCursor(-1, 0); });
+
+    auto rightShortcut = new QShortcut(QKeySequence(Qt::Key_Right), this);
+    connect(rightShortcut, &QShortcut::activated, m_view, [this](){ m_view->nudgeCursor(1, 0); });
+
+    auto upShortcut = new QShortcut(QKeySequence(Qt::Key_Up), this);
+    connect(upShortcut, &QShortcut::activated, m_view, [this](){ m_view->nudgeCursor(0, -1); });
+
+    auto downShortcut = new QShortcut(QKeySequence(Qt::Key_Down), this);
+    connect(downShortcut, &QShortcut::activated, m_view, [this](){ m_view->nudgeCursor(0, 1); });
+
+    auto liveShortcut = new QShortcut(QKeySequence(Qt::Key_Escape), this);
+    connect(liveShortcut, &QShortcut::activated, this, &Window::resumeLiveCapture);
+
+    connect(&m_captureWatcher, &QFutureWatcher<QImage>::finished, this, &Window::onCaptureFinished);
+
+    m_frameRingTimer = new QTimer(this);
+    m_frameRingTimer->setInterval(kFrameRingPollInterval);
+    connect(m_frameRingTimer, &QTimer::timeout, this, &Window::pollFrameRing);
+}
+
+View* Window::view() const
+{
+    return m_view;
+}
+
+void Window::setStartupReportEnabled(bool isEnabled)
+{
+    m_isStartupReportEnabled = isEnabled;
+}
+
+bool Window::openSession(const QString& fileName)
+{
+    RenderData renderData;
+    EdgeMap edgeMap;
+
+    if (!Session::load(fileName, renderData, edgeMap))
+    {
+        return false;
+    }
+
+    closeFrameRing();
+    m_isCaptureFrozen = true;
+    m_view->restoreSession(renderData, edgeMap);
+    m_view->show();
+
+    return true;
+}
+
+bool Window::openFrameRing(const QString& name)
+{
+    if (!m_frameRing.open(name))
+    {
+        return false;
+    }
+
+    m_isCaptureFrozen = true;
+    m_frameRingGeneration = 0;
+    m_frameRingTimer->start();
+    pollFrameRing();
+
+    return true;
+}
+
+void Window::pollFrameRing()
+{
+    quint64 generation;
+    auto image = m_frameRing.frame(&generation);
+
+    if (generation == m_frameRingGeneration || image.isNull())
+    {
+        return;
+    }
+
+    m_frameRingGeneration = generation;
+    m_view->setImage(image);
+    m_view->show();
+}
+
+void Window::closeFrameRing()
+{
+    m_frameRingTimer->stop();
+    m_frameRing.close();
 }
 
 void Window::enterEvent(QEvent*)
 {
     static bool isFirstEnter{true};
 
-    grabScreen();
+    if (!m_isCaptureFrozen)
+    {
+        grabScreen();
+    }
 
-    if (!isFirstEnter)
+    if (!isFirstEnter && !m_isCaptureFrozen)
     {
         m_view->shiftScene(m_lastWindowPos.x() - pos().x(),
                            m_lastWindowPos.y() - pos().y());
@@ -81,23 +209,374 @@ void Window::leaveEvent(QEvent*)
     m_view->hide();
 }
 
+void Window::showEvent(QShowEvent* event)
+{
+    static bool isFirstShow{true};
+
+    QMainWindow::showEvent(event);
+
+    if (isFirstShow && !m_isCaptureFrozen)
+    {
+        startCapture();
+    }
+
+    isFirstShow = false;
+}
+
+void Window::paintEvent(QPaintEvent* event)
+{
+    QMainWindow::paintEvent(event);
+
+    if (m_firstFrameTime < 0)
+    {
+        m_firstFrameTime = Profiler::sinceStartup();
+        reportStartup();
+    }
+}
+
 void Window::grabScreen()
 {
-    auto screen = QGuiApplication::primaryScreen();
-    auto descktop = QApplication::desktop();
-    auto winId = descktop->winId();
+    if (m_captureWatcher.isRunning())
+    {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    auto image = m_capturer.grab(geometry().adjusted(1, 1, -1, -1));
+    auto grabTime = timer.elapsed();
+
+    m_view->setImage(image);
+    logCapture(image, grabTime);
+}
+
+void Window::startCapture()
+{
+    if (!m_capturer.isSharedMemoryAvailable())
+    {
+        QTimer::singleShot(0, this, [this](){
+            if (!m_isCaptureFrozen)
+            {
+                grabScreen();
+            }
+        });
+        return;
+    }
+
+    auto rect = geometry().adjusted(1, 1, -1, -1);
+
+    m_captureTimer.start();
+    m_captureWatcher.setFuture(QtConcurrent::run([this, rect](){
+        return m_capturer.grabSharedMemory(rect);
+    }));
+}
+
+void Window::onCaptureFinished()
+{
+    if (m_captureWatcher.future().resultCount() == 0 || m_isCaptureFrozen)
+    {
+        return;
+    }
+
+    auto image = m_captureWatcher.result();
+
+    if (image.isNull())
+    {
+        image = m_capturer.grabQt(geometry().adjusted(1, 1, -1, -1));
+    }
+
+    m_view->setImage(image);
+    logCapture(image, m_captureTimer.elapsed());
+}
+
+void Window::logCapture(const QImage& image, qint64 grabTime)
+{
+    if (!m_isStartupReportEnabled)
+    {
+        return;
+    }
 
-    m_view->setPixmap(
-                screen->grabWindow(winId).copy(
-                    geometry().adjusted(1, 1, -1, -1)));
+    qInfo().noquote() << QString("Captured %1x%2: grab %3 ms, buffer allocations %4 (%5 MB), "
+                                 "reused %6, peak RSS %7 MB")
+                         .arg(image.width())
+                         .arg(image.height())
+                         .arg(grabTime)
+                         .arg(Profiler::bufferAllocationCount())
+                         .arg(Profiler::bufferAllocatedBytes() / (1024 * 1024))
+                         .arg(BufferPool::reuseCount())
+                         .arg(Profiler::peakResidentBytes() / (1024 * 1024));
+}
+
+void Window::saveSession()
+{
+    auto fileName = QFileDialog::getSaveFileName(this, "Save session", {}, kSessionFilter);
+
+    if (!fileName.isEmpty())
+    {
+        Session::save(fileName, m_view->renderData(), m_view->edgeMap());
+    }
+}
+
+void Window::openFile()
+{
+    auto fileName = QFileDialog::getOpenFileName(this, "Open", {},
+                                                 kSessionFilter + ";;" + kImageFilter);
+
+    if (fileName.isEmpty())
+    {
+        return;
+    }
+
+    if (!fileName.endsWith(".spms", Qt::CaseInsensitive))
+    {
+        openImage(fileName);
+    }
+    else
+    {
+        openSession(fileName);
+    }
+}
+
+void Window::openImage(const QString& fileName)
+{
+    m_imageTimer.start();
+    m_imageWatcher.setFuture(QtConcurrent::run(&TiledImage::load, fileName, kTiledImageMemoryLimit));
+}
+
+void Window::onImageLoaded()
+{
+    if (m_imageWatcher.future().resultCount() == 0)
+    {
+        return;
+    }
+
+    auto image = m_imageWatcher.result();
+
+    if (image.isNull())
+    {
+        qWarning() << "Cannot open image:" << image.errorString();
+        return;
+    }
+
+    auto decodeTime = m_imageTimer.elapsed();
+
+    closeFrameRing();
+    m_isCaptureFrozen = true;
+    m_view->setTiledImage(image);
+    m_view->show();
+    m_view->viewport()->repaint();
+
+    qInfo().noquote() << QString("Opened %1x%2 image: decode %3 ms, first paint %4 ms, "
+                                 "resident tiles %5 MB, peak RSS %6 MB")
+                         .arg(image.size().width())
+                         .arg(image.size().height())
+                         .arg(decodeTime)
+                         .arg(m_imageTimer.elapsed())
+                         .arg(image.residentBytes() / (1024 * 1024))
+                         .arg(Profiler::peakResidentBytes() / (1024 * 1024));
+}
+
+void Window::exportRedline()
+{
+    if (m_exportWatcher.isRunning())
+    {
+        return;
+    }
+
+    auto fileName = QFileDialog::getSaveFileName(this, "Export redline", {}, kRedlineFilter);
+
+    if (!fileName.isEmpty())
+    {
+        m_exportTimer.start();
+        m_exportWatcher.setFuture(QtConcurrent::run(&Redline::save, fileName,
+                                                    m_view->renderData(), m_view->palette()));
+    }
+}
+
+void Window::onRedlineExported()
+{
+    if (m_exportWatcher.future().resultCount() == 0)
+    {
+        return;
+    }
+
+    const auto& size = m_view->renderData().screenImage.size();
+
+    qInfo().noquote() << QString("Redline export %1x%2 %3 in %4 ms")
+                         .arg(size.width())
+                         .arg(size.height())
+                         .arg(m_exportWatcher.result() ? "done" : "failed")
+                         .arg(m_exportTimer.elapsed());
+}
+
+void Window::resumeLiveCapture()
+{
+    if (m_isCaptureFrozen)
+    {
+        closeFrameRing();
+        m_isCaptureFrozen = false;
+        grabScreen();
+    }
+}
+
+void Window::toggleReferenceImage()
+{
+    if (m_view->renderData().isReferencePresent)
+    {
+        m_view->clearReferenceImage();
+        return;
+    }
+
+    auto fileName = QFileDialog::getOpenFileName(this, "Open reference", {}, kImageFilter);
+    QImage image(fileName);
+
+    if (!image.isNull())
+    {
+        m_view->setReferenceImage(image.convertToFormat(QImage::Format_RGB32));
+    }
 }
 
 void Window::updateTitle(const RenderData& renderData)
 {
-    auto info = renderData.cursorColor.isValid()
-            ? "; Color: " + renderData.cursorColor.name()
-            : "";
+    m_title.resize(0);
+    m_title.append(kTitle);
+
+    if (renderData.cursorColor.isValid())
+    {
+        appendTitle("; Color: #%06x", renderData.cursorColor.rgb() & RGB_MASK);
+    }
+
+    if (!renderData.colorStats.isNull())
+    {
+        const auto& stats = renderData.colorStats;
+        const auto& histogram = stats.histogram();
+        const auto peak = qMax<qint64>(1, *std::max_element(histogram.begin(), histogram.end()));
+
+        appendTitle("; Avg: #%06x, Min: #%06x, Max: #%06x, Unique: %d, Luma: [",
+                    stats.average().rgb() & RGB_MASK,
+                    stats.minimum().rgb() & RGB_MASK,
+                    stats.maximum().rgb() & RGB_MASK,
+                    stats.uniqueCount());
+
+        for (auto count : histogram)
+        {
+            m_title.append(kLumaBars[int((count * (kLumaBars.size() - 1) + peak - 1) / peak)]);
+        }
+
+        m_title.append(QLatin1Char(']'));
+    }
+
+    if (renderData.isClearancePresent && !renderData.clearanceLine.isNull())
+    {
+        appendTitle("; Clearance: %.1f", renderData.clearance);
+    }
+
+    if (renderData.isFixedRectPresent && renderData.fixedRectTransitions == 0)
+    {
+        appendTitle("; Fixed rect: uniform");
+    }
+    else if (renderData.isFixedRectPresent && renderData.fixedRectTransitions > 0)
+    {
+        appendTitle("; Fixed rect: %d color changes", renderData.fixedRectTransitions);
+    }
+
+    if (renderData.isAlignmentPresent && renderData.isFixedRectPresent)
+    {
+        appendTitle("; Aligned edges (%d px): %d",
+                    renderData.alignmentTolerance,
+                    renderData.alignmentLines.size());
+    }
+
+    if (renderData.isTextPresent)
+    {
+        const auto& t = renderData.cursorRectangle;
+
+        appendTitle("; Text: %dx%d, baseline %d (%d above bottom)",
+                    t.width() + 1,
+                    t.height() + 1,
+                    renderData.baselineLine.y1(),
+                    t.y() + t.height() - renderData.baselineLine.y1());
+    }
+
+    if (renderData.isSubpixelPresent)
+    {
+        const auto& r = renderData.subpixelRectangle;
+
+        appendTitle("; Sub-pixel: %.2fx%.2f at %.2f, %.2f", r.width(), r.height(), r.x(), r.y());
+    }
+
+    if (renderData.isContainerPresent)
+    {
+        const auto& c = renderData.cursorRectangle;
+        const auto& p = renderData.containerRectangle;
+
+        appendTitle("; Container %d: %dx%d, insets l %d, t %d, r %d, b %d",
+                    renderData.containerLevel,
+                    p.width() + 1,
+                    p.height() + 1,
+                    c.left() - p.left(),
+                    c.top() - p.top(),
+                    p.x() + p.width() - c.x() - c.width(),
+                    p.y() + p.height() - c.y() - c.height());
+    }
+
+    if (renderData.isReferencePresent && !renderData.referenceRectangle.isNull())
+    {
+        const auto& c = renderData.cursorRectangle;
+        const auto& r = renderData.referenceRectangle;
+
+        appendTitle("; Reference delta: w %d, h %d, x %d, y %d",
+                    r.width() - c.width(),
+                    r.height() - c.height(),
+                    r.x() - c.x(),
+                    r.y() - c.y());
+    }
+
+    if (m_title != windowTitle())
+    {
+        // The widget now shares m_title; build the next title in the other reserved buffer.
+        setWindowTitle(m_title);
+        m_title.swap(m_shownTitle);
+    }
+
+    if (m_firstMeasurementTime < 0 && !renderData.screenImage.isNull())
+    {
+        m_firstMeasurementTime = Profiler::sinceStartup();
+        reportStartup();
+    }
+}
+
+void Window::appendTitle(const char* format, ...)
+{
+    char field[kTitleFieldSize];
+    va_list args;
+
+    va_start(args, format);
+    vsnprintf(field, sizeof(field), format, args);
+    va_end(args);
+
+    m_title.append(QLatin1String(field));
+}
+
+void Window::reportStartup()
+{
+    if (m_firstFrameTime < 0 || m_firstMeasurementTime < 0)
+    {
+        return;
+    }
+
+    auto report = QString("Startup: first frame %1 ms, first measurement %2 ms")
+            .arg(m_firstFrameTime)
+            .arg(m_firstMeasurementTime);
+
+    if (!m_isStartupReportEnabled)
+    {
+        qInfo().noquote() << report;
+        return;
+    }
 
-    setWindowTitle(kTitle + info);
+    QTextStream(stdout) << report << "\n";
+    QTimer::singleShot(0, qApp, &QApplication::quit);
 }
 
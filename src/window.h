@@ -2,9 +2,15 @@
 #define WINDOW_H
 
 #include <QMainWindow>
+#include <QFutureWatcher>
+#include <QElapsedTimer>
+
 #include "data.h"
+#include "screencapturer.h"
+#include "framering.h"
 
 class View;
+class QTimer;
 
 class Window : public QMainWindow
 {
@@ -12,23 +18,82 @@ class Window : public QMainWindow
 
     const QString kTitle{"LMB - add/remove fixed rect; "
                          "Mouse Wheel - zooming; "
+                         "Ctrl+Wheel - parent container; "
                          "RMB - panning; "
                          "P - switch palette; "
-                         "Space - remove fixed rect"};
+                         "Space - remove fixed rect; "
+                         "Ctrl+S - save session; "
+                         "Ctrl+O - open session or image; "
+                         "Ctrl+R - load/clear reference; "
+                         "Ctrl+E - export redline; "
+                         "N - next difference; "
+                         "H - clearance heatmap; "
+                         "G - pixel grid; "
+                         "T - text bounds; "
+                         "S - sub-pixel edges; "
+                         "A - aligned edges; "
+                         "Arrows - move cursor by pixel; "
+                         "Esc - live capture"};
+    const QString kSessionFilter{"Measurer session (*.spms)"};
+    const QString kRedlineFilter{"Redline (*.png)"};
+    const QString kImageFilter{"Images (*.png *.tif *.tiff *.jpg *.jpeg *.bmp)"};
+    const qint64 kTiledImageMemoryLimit{512 * 1024 * 1024};
+    const int kFrameRingPollInterval{8};
+    const int kTitleCapacity{1024};
+    static constexpr int kTitleFieldSize{128};
+    const QString kLumaBars{" \u2581\u2582\u2583\u2584\u2585\u2586\u2587\u2588"};
 public:
     explicit Window(QWidget* parent = nullptr);
 
+    View* view() const;
+    bool openSession(const QString& fileName);
+    bool openFrameRing(const QString& name);
+    void setStartupReportEnabled(bool isEnabled);
+
 protected:
     void enterEvent(QEvent* event) override;
     void leaveEvent(QEvent* event) override;
+    void showEvent(QShowEvent* event) override;
+    void paintEvent(QPaintEvent* event) override;
 
 private:
     View* m_view;
     QPoint m_lastWindowPos;
+    bool m_isCaptureFrozen{false};
+    QFutureWatcher<TiledImage> m_imageWatcher;
+    QElapsedTimer m_imageTimer;
+    ScreenCapturer m_capturer;
+    QFutureWatcher<QImage> m_captureWatcher;
+    QElapsedTimer m_captureTimer;
+    QFutureWatcher<bool> m_exportWatcher;
+    QElapsedTimer m_exportTimer;
+    qint64 m_firstFrameTime{-1};
+    qint64 m_firstMeasurementTime{-1};
+    bool m_isStartupReportEnabled{false};
+    FrameRing m_frameRing;
+    QTimer* m_frameRingTimer;
+    quint64 m_frameRingGeneration{0};
+    QString m_title;
+    QString m_shownTitle;
 
 private:
     void initialize();
     void grabScreen();
+    void startCapture();
+    void onCaptureFinished();
+    void logCapture(const QImage& image, qint64 grabTime);
+    void reportStartup();
+    void appendTitle(const char* format, ...) Q_ATTRIBUTE_FORMAT_PRINTF(2, 3);
+    void saveSession();
+    void openFile();
+    void openImage(const QString& fileName);
+    void onImageLoaded();
+    void pollFrameRing();
+    void closeFrameRing();
+    void exportRedline();
+    void onRedlineExported();
+    void resumeLiveCapture();
+    void toggleReferenceImage();
     void updateTitle(const RenderData& renderData);
 };
 